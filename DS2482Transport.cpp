@@ -0,0 +1,205 @@
+/*!
+ * @file DS2482Transport.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DS2482Transport.h"
+
+#if REQUIRESDS2482
+
+// DS2482 commands
+#define DS2482_DEVICE_RESET 0xF0
+#define DS2482_SET_READ_POINTER 0xE1
+#define DS2482_WRITE_CONFIG 0xD2
+#define DS2482_CHANNEL_SELECT 0xC3
+#define DS2482_1WIRE_RESET 0xB4
+#define DS2482_1WIRE_SINGLE_BIT 0x87
+#define DS2482_1WIRE_WRITE_BYTE 0xA5
+#define DS2482_1WIRE_READ_BYTE 0x96
+#define DS2482_1WIRE_TRIPLET 0x78
+
+// read pointer codes
+#define DS2482_STATUS_REGISTER 0xF0
+#define DS2482_DATA_REGISTER 0xE1
+
+// status register bits
+#define DS2482_STATUS_1WB 0x01 // 1-Wire busy
+#define DS2482_STATUS_PPD 0x02 // presence pulse detected
+#define DS2482_STATUS_RST 0x10 // device reset
+#define DS2482_STATUS_SBR 0x20 // single bit result
+#define DS2482_STATUS_TSB 0x40 // triplet second bit
+#define DS2482_STATUS_DIR 0x80 // branch direction taken
+
+// configuration register bits
+#define DS2482_CONFIG_APU 0x01 // active pullup
+#define DS2482_CONFIG_SPU 0x04 // strong pullup
+
+// longest 1-Wire operation (a reset) is about 1.2ms
+#define DS2482_TIMEOUT_MS 5
+
+TwoWire *DS2482Transport::_bridgeWire[8];
+uint8_t DS2482Transport::_bridgeChannel[8];
+
+DS2482Transport::DS2482Transport(TwoWire *wire, uint8_t address,
+                                 uint8_t channel) {
+  _i2c = wire;
+  _address = address;
+  _channel = channel;
+  _config = DS2482_CONFIG_APU;
+}
+
+// resets the bridge and writes the default configuration
+bool DS2482Transport::begin(void) {
+  if (!command(DS2482_DEVICE_RESET))
+    return false;
+  if (!(waitIdle() & DS2482_STATUS_RST))
+    return false;
+  // a device reset leaves a DS2482-800 on channel 0
+  _bridgeWire[_address & 0x07] = _i2c;
+  _bridgeChannel[_address & 0x07] = 0;
+  return writeConfig(_config);
+}
+
+// selects a DS2482-800 channel, the bridge echoes a channel specific code
+bool DS2482Transport::selectChannel(uint8_t channel) {
+  static const uint8_t codes[8] = {0xF0, 0xE1, 0xD2, 0xC3,
+                                   0xB4, 0xA5, 0x96, 0x87};
+  static const uint8_t readBack[8] = {0xB8, 0xB1, 0xAA, 0xA3,
+                                      0x9C, 0x95, 0x8E, 0x87};
+  if (channel > 7)
+    return false;
+  _channel = channel;
+  waitIdle();
+
+  // unknown until the bridge confirms the switch
+  _bridgeWire[_address & 0x07] = _i2c;
+  _bridgeChannel[_address & 0x07] = DS2482_NO_CHANNEL;
+  if (!command(DS2482_CHANNEL_SELECT, codes[channel]))
+    return false;
+  // the bridge answers with the channel code, then waitIdle() needs the read
+  // pointer back on the status register
+  bool selected = _i2c->requestFrom(_address, (uint8_t)1) == 1 &&
+                  _i2c->read() == readBack[channel];
+  command(DS2482_SET_READ_POINTER, DS2482_STATUS_REGISTER);
+  if (selected)
+    _bridgeChannel[_address & 0x07] = channel;
+  return selected;
+}
+
+// every transaction, search() included, starts with reset(), so that is where
+// a bus shared with other channels of the bridge is switched back
+bool DS2482Transport::useChannel(void) {
+  if (_channel == DS2482_NO_CHANNEL)
+    return true;
+  if (_bridgeWire[_address & 0x07] == _i2c &&
+      _bridgeChannel[_address & 0x07] == _channel)
+    return true;
+  return selectChannel(_channel);
+}
+
+uint8_t DS2482Transport::reset(void) {
+  if (!useChannel())
+    return 0;
+  waitIdle();
+  command(DS2482_1WIRE_RESET);
+  return (waitIdle() & DS2482_STATUS_PPD) ? 1 : 0;
+}
+
+void DS2482Transport::write_bit(uint8_t v) {
+  waitIdle();
+  command(DS2482_1WIRE_SINGLE_BIT, v ? 0x80 : 0x00);
+}
+
+uint8_t DS2482Transport::read_bit(void) {
+  // a read slot is a write slot of 1 the device may pull low
+  write_bit(1);
+  return (waitIdle() & DS2482_STATUS_SBR) ? 1 : 0;
+}
+
+void DS2482Transport::write(uint8_t v, uint8_t power) {
+  waitIdle();
+  // the strong pullup engages after the next byte
+  if (power)
+    writeConfig(_config | DS2482_CONFIG_SPU);
+  command(DS2482_1WIRE_WRITE_BYTE, v);
+}
+
+uint8_t DS2482Transport::read(void) {
+  waitIdle();
+  command(DS2482_1WIRE_READ_BYTE);
+  waitIdle();
+  return readRegister(DS2482_DATA_REGISTER);
+}
+
+void DS2482Transport::depower(void) {
+  waitIdle();
+  writeConfig(_config);
+}
+
+// the bridge runs both read slots and the write slot itself
+uint8_t DS2482Transport::triplet(uint8_t direction) {
+  waitIdle();
+  command(DS2482_1WIRE_TRIPLET, direction ? 0x80 : 0x00);
+  uint8_t status = waitIdle();
+
+  uint8_t result = 0;
+  if (status & DS2482_STATUS_SBR)
+    result |= 0x01;
+  if (status & DS2482_STATUS_TSB)
+    result |= 0x02;
+  if (status & DS2482_STATUS_DIR)
+    result |= 0x04;
+  return result;
+}
+
+// sends a command with an optional parameter byte
+bool DS2482Transport::command(uint8_t cmd, int16_t param) {
+  _i2c->beginTransmission(_address);
+  _i2c->write(cmd);
+  if (param >= 0)
+    _i2c->write((uint8_t)param);
+  return _i2c->endTransmission() == 0;
+}
+
+// polls the status register until the 1-Wire line is idle, returns the last
+// status read. Most commands leave the read pointer on the status register
+uint8_t DS2482Transport::waitIdle(void) {
+  uint8_t status = 0;
+  unsigned long start = millis();
+  do {
+    if (_i2c->requestFrom(_address, (uint8_t)1) != 1)
+      return 0;
+    status = _i2c->read();
+  } while ((status & DS2482_STATUS_1WB) &&
+           (millis() - start) < DS2482_TIMEOUT_MS);
+  return status;
+}
+
+// reads a register after setting the read pointer to it, the pointer is put
+// back on the status register afterwards
+uint8_t DS2482Transport::readRegister(uint8_t pointer) {
+  command(DS2482_SET_READ_POINTER, pointer);
+  uint8_t value = 0;
+  if (_i2c->requestFrom(_address, (uint8_t)1) == 1)
+    value = _i2c->read();
+  command(DS2482_SET_READ_POINTER, DS2482_STATUS_REGISTER);
+  return value;
+}
+
+// writes the configuration register, the upper nibble is the complement of
+// the lower one
+bool DS2482Transport::writeConfig(uint8_t config) {
+  if (!command(DS2482_WRITE_CONFIG, (config & 0x0F) | ((~config & 0x0F) << 4)))
+    return false;
+  // the bridge answers with the new configuration, then waitIdle() needs the
+  // read pointer back on the status register
+  bool written = _i2c->requestFrom(_address, (uint8_t)1) == 1 &&
+                 (_i2c->read() & 0x0F) == (config & 0x0F);
+  command(DS2482_SET_READ_POINTER, DS2482_STATUS_REGISTER);
+  return written;
+}
+
+#endif
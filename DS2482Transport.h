@@ -0,0 +1,98 @@
+/*!
+ * @file DS2482Transport.h
+ */
+#ifndef DS2482Transport_h
+#define DS2482Transport_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#if REQUIRESDS2482
+
+#include <Wire.h>
+
+#define DS2482_ADDRESS 0x18    //!< I2C address with AD0/AD1 grounded
+#define DS2482_NO_CHANNEL 0xFF //!< DS2482-100, no channel to select
+
+/*!
+ * @brief transport over a DS2482-100 or DS2482-800 I2C to 1-Wire bridge. The
+ * bridge generates the time slots itself, so interrupts stay enabled and the
+ * ROM search uses its triplet command. On a DS2482-800 use one instance per
+ * channel: each reset re-selects the instance's channel if another instance
+ * of the same bridge switched it
+ */
+class DS2482Transport : public DallasTemperatureTransport {
+public:
+  /*!
+   * @brief DS2482Transport constructor
+   * @param wire I2C bus the bridge is on
+   * @param address I2C address of the bridge
+   * @param channel DS2482-800 channel 0-7 of this bus, DS2482_NO_CHANNEL for
+   * a DS2482-100
+   */
+  DS2482Transport(TwoWire *wire = &Wire, uint8_t address = DS2482_ADDRESS,
+                  uint8_t channel = DS2482_NO_CHANNEL);
+
+  /*!
+   * @brief resets the bridge and enables the active pullup. Call Wire.begin()
+   * first. The reset is shared by every channel of the bridge, so one
+   * instance per bridge is enough
+   * @return Returns true if the bridge answered
+   */
+  bool begin(void);
+
+  /*!
+   * @brief moves this instance to another DS2482-800 channel and selects it
+   * @param channel Channel 0-7
+   * @return Returns true if the bridge switched to the channel
+   */
+  bool selectChannel(uint8_t channel);
+
+  uint8_t reset(void);
+  void write_bit(uint8_t v);
+  uint8_t read_bit(void);
+  void write(uint8_t v, uint8_t power = 0);
+  uint8_t read(void);
+  void depower(void);
+
+protected:
+  uint8_t triplet(uint8_t direction);
+
+private:
+  TwoWire *_i2c;
+  uint8_t _address;
+
+  // channel of this bus, DS2482_NO_CHANNEL for a DS2482-100
+  uint8_t _channel;
+
+  // the channel each bridge (by its AD2-AD0 address bits) last selected,
+  // shared by all instances
+  static TwoWire *_bridgeWire[8];
+  static uint8_t _bridgeChannel[8];
+
+  // selects this instance's channel if the bridge is on another one
+  bool useChannel(void);
+
+  // configuration register, low nibble
+  uint8_t _config;
+
+  // sends a command with an optional parameter byte
+  bool command(uint8_t cmd, int16_t param = -1);
+
+  // polls the status register until the 1-Wire line is idle
+  uint8_t waitIdle(void);
+
+  // reads a register after setting the read pointer to it
+  uint8_t readRegister(uint8_t pointer);
+
+  // writes the configuration register
+  bool writeConfig(uint8_t config);
+};
+
+#endif
+
+#endif
@@ -34,59 +34,505 @@ extern "C" {
 }
 #endif
 
+// family code of a device. With REQUIRESMODEL set it is a constant, so the
+// compiler drops the code of every other model
+#define DEVICE_FAMILY(deviceAddress)                                           \
+  (REQUIRESMODEL ? REQUIRESMODEL : (deviceAddress)[0])
+
+// scratchpad buffer of a call, the object's shared one with
+// REQUIRESLOWMEMORY
+#if REQUIRESLOWMEMORY
+#define SCRATCHPAD(name) uint8_t *name = sharedScratchPad
+#else
+#define SCRATCHPAD(name) ScratchPad name
+#endif
+
+// statistics counters, they compile to nothing without REQUIRESSTATS
+#if REQUIRESSTATS
+// times are kept in milliseconds, so they don't wrap after about 72 minutes
+// like a sum of micros() would, the rest below a millisecond is carried
+static void statsAddTime(uint32_t *millisCounter, uint16_t *microsCounter,
+                         unsigned long start) {
+  uint32_t elapsed = micros() - start + *microsCounter;
+  *millisCounter += elapsed / 1000;
+  *microsCounter = elapsed % 1000;
+}
+
+#define STATS_COUNT(counter) (stats.counter++)
+#define STATS_START() unsigned long statsStart = micros()
+#define STATS_ADD(counter)                                                     \
+  statsAddTime(&stats.counter##Millis, &stats.counter##Micros, statsStart)
+#else
+#define STATS_COUNT(counter) ((void)0)
+#define STATS_START() ((void)0)
+#define STATS_ADD(counter) ((void)0)
+#endif
+
+// devices of other families are ignored when REQUIRESMODEL is set
+#define MODEL_SUPPORTED(deviceAddress)                                         \
+  (REQUIRESMODEL == 0 || (deviceAddress)[0] == REQUIRESMODEL)
+
 DallasTemperature::DallasTemperature(OneWire *_oneWire)
+    : _oneWireTransport(_oneWire)
+#if REQUIRESALARMS
+      ,
+      _AlarmHandler(&defaultAlarmHandler)
+#endif
+{
+  _wire = &_oneWireTransport;
+  init();
+}
+
+DallasTemperature::DallasTemperature(DallasTemperatureTransport *transport)
 #if REQUIRESALARMS
     : _AlarmHandler(&defaultAlarmHandler)
 #endif
 {
-  _wire = _oneWire;
+  _wire = transport;
+  init();
+}
+
+// sets the state shared by the constructors
+void DallasTemperature::init(void) {
   devices = 0;
   parasite = false;
   bitResolution = 9;
   waitForConversion = true;
   checkForConversion = true;
+  partialRead = false;
+  retries = 0;
+#if FILTERDEPTH
+  filter = FILTER_NONE;
+#endif
+  autoSaveScratchPad = true;
+  conversionState = CONVERSION_IDLE;
+  conversionStart = 0;
+  conversionIndex = 0;
+  groupsConverting = 0;
+#if REQUIRESCHANGES
+  _ChangeHandler = 0;
+#endif
+  memset(slotTable, 0xFF, sizeof(slotTable));
+  unverifiedDevices = 0;
+  tableMismatch = false;
+#if REQUIRESDISCOVERY
+  discovery = false;
+  discoveryActive = false;
+  discoveryUntracked = 0;
+  _AddedHandler = 0;
+  _RemovedHandler = 0;
+#endif
+#if REQUIRESSTATS
+  resetStats();
+#endif
 }
 
 // initialise the bus
 void DallasTemperature::begin(void) {
   DeviceAddress deviceAddress;
 
+  // any parasite powered device pulls the bus low, so one query covers all
+  parasite = readPowerSupply();
+
   _wire->reset_search();
   devices = 0; // Reset the number of devices when we enumerate wire devices
+  memset(slotTable, 0xFF, sizeof(slotTable));
+  unverifiedDevices = 0;
+  tableMismatch = false;
+
+  while (searchBus(deviceAddress)) {
+    if (validAddress(deviceAddress) && MODEL_SUPPORTED(deviceAddress))
+      cacheDevice(deviceAddress);
+  }
+
+#if REQUIRESDISCOVERY
+  discoveryActive = false;
+#endif
+}
+
+// counts a device found by a search and adds it to the device table if
+// there is room
+void DallasTemperature::cacheDevice(uint8_t *deviceAddress) {
+  // a single CRC checked scratchpad read gives resolution and config
+  SCRATCHPAD(scratchPad);
+  uint8_t resolution = 0;
+  if (isConnected(deviceAddress, scratchPad))
+    resolution = resolutionFromScratchPad(deviceAddress, scratchPad);
+  bitResolution = max(bitResolution, resolution);
+
+  // remember the device so index lookups don't need to search again
+  if (devices < MAXDEVICES) {
+    DeviceEntry *entry = &deviceTable[devices];
+    memcpy(entry->address, deviceAddress, sizeof(DeviceAddress));
+    entry->resolution = resolution;
+    entry->highAlarm = scratchPad[HIGH_ALARM_TEMP];
+    entry->lowAlarm = scratchPad[LOW_ALARM_TEMP];
+    entry->lastRaw = DEVICE_DISCONNECTED_RAW;
+    entry->newReading = false;
+    entry->verified = true;
+#if REQUIRESCHANGES
+    entry->reportedRaw = DEVICE_DISCONNECTED_RAW;
+    entry->deadband = 0;
+    entry->alarmArmed = false;
+#endif
+#if REQUIRESDISCOVERY
+    entry->seen = false;
+    entry->missing = false;
+#endif
+#if REQUIRESHEALTH
+    entry->failures = 0;
+    entry->skip = 0;
+#endif
+#if FILTERDEPTH
+    entry->sampleCount = 0;
+    entry->sampleNext = 0;
+#endif
+#if REQUIRESSTATS
+    entry->crcFailures = 0;
+#endif
+
+    // MAX31850 report their AD3-AD0 pins in the configuration byte
+    uint8_t slot = scratchPad[MAX31850_ADDRESS] & 0x0F;
+    if (DEVICE_FAMILY(deviceAddress) == MAX31850MODEL && resolution != 0 &&
+        slotTable[slot] == 0xFF)
+      slotTable[slot] = devices;
+  }
 
-  while (_wire->search(deviceAddress)) {
-    if (validAddress(deviceAddress)) {
-      if (!parasite && readPowerSupply(deviceAddress))
-        parasite = true;
+  devices++;
+}
 
-      ScratchPad scratchPad;
+#if REQUIRESDISCOVERY
 
-      readScratchPad(deviceAddress, scratchPad);
+// drops a device from the device table, later devices move up one index
+void DallasTemperature::removeDevice(uint8_t deviceIndex) {
+  if (!deviceTable[deviceIndex].verified)
+    unverifiedDevices--;
 
-      bitResolution = max(bitResolution, getResolution(deviceAddress));
+  for (uint8_t i = deviceIndex; i + 1 < cachedDeviceCount(); i++)
+    deviceTable[i] = deviceTable[i + 1];
+  devices--;
 
-      devices++;
+  for (uint8_t slot = 0; slot < MAX31850_SLOTS; slot++) {
+    if (slotTable[slot] == 0xFF || slotTable[slot] < deviceIndex)
+      continue;
+    if (slotTable[slot] == deviceIndex)
+      slotTable[slot] = 0xFF;
+    else
+      slotTable[slot]--;
+  }
+}
+
+// sets the discovery handlers
+void DallasTemperature::setDiscoveryHandlers(DiscoveryHandler *added,
+                                             DiscoveryHandler *removed) {
+  _AddedHandler = added;
+  _RemovedHandler = removed;
+}
+
+// lets poll() run a discovery step whenever the bus is idle
+void DallasTemperature::setDiscovery(bool flag) { discovery = flag; }
+
+// returns true if poll() runs discovery steps
+bool DallasTemperature::getDiscovery(void) { return discovery; }
+
+// runs one search() of a discovery pass. Devices not in the device table
+// are added when found, devices that weren't found in two complete passes in
+// a row are removed, a single pass may end early on a bus glitch. Devices
+// that don't fit the table are only counted, devices counts them again at
+// the end of the pass. devices only exceeds the table while it is full
+bool DallasTemperature::discoveryStep(void) {
+  if (!discoveryActive) {
+    _wire->reset_search();
+    for (uint8_t i = 0; i < cachedDeviceCount(); i++)
+      deviceTable[i].seen = false;
+    discoveryUntracked = 0;
+    discoveryActive = true;
+  }
+
+  DeviceAddress deviceAddress;
+  if (searchBus(deviceAddress)) {
+    if (!validAddress(deviceAddress) || !MODEL_SUPPORTED(deviceAddress))
+      return true;
+
+    DeviceEntry *entry = findDevice(deviceAddress);
+    if (entry == 0 && devices < MAXDEVICES) {
+      parasite = parasite || readPowerSupply(deviceAddress);
+      cacheDevice(deviceAddress);
+      entry = &deviceTable[devices - 1];
+      if (_AddedHandler)
+        _AddedHandler(deviceAddress);
     }
+    if (entry) {
+      entry->seen = true;
+      entry->missing = false;
+    } else if (discoveryUntracked < 255)
+      discoveryUntracked++;
+    return true;
   }
+
+  // end of the pass, removeDevice() needs devices to match the table
+  discoveryActive = false;
+  devices = cachedDeviceCount();
+  for (uint8_t i = devices; i > 0; i--) {
+    DeviceEntry *entry = &deviceTable[i - 1];
+    if (entry->seen)
+      continue;
+    if (!entry->missing) {
+      entry->missing = true;
+      continue;
+    }
+
+    memcpy(deviceAddress, entry->address, sizeof(DeviceAddress));
+    removeDevice(i - 1);
+    if (_RemovedHandler)
+      _RemovedHandler(deviceAddress);
+  }
+  // once a removal made room, the next pass adds the untracked devices
+  if (devices == MAXDEVICES)
+    devices = min(devices + discoveryUntracked, 255);
+  return false;
 }
 
+#endif
+
+// saved device table: magic, device count, parasite, bus resolution, then
+// address, resolution, TH, TL and MAX31850 location of every cached device
+// and a CRC8 of all of it
+#define DEVICETABLE_MAGIC 0xD7
+#define DEVICETABLE_HEADER 4
+#define DEVICETABLE_ENTRY 12
+#define DEVICETABLE_NO_SLOT 0xFF
+
+uint16_t DallasTemperature::getDeviceTableSize(void) {
+  return DEVICETABLE_HEADER + cachedDeviceCount() * DEVICETABLE_ENTRY + 1;
+}
+
+void DallasTemperature::saveDeviceTable(DeviceTableWriter *writer) {
+  uint16_t offset = 0;
+  uint8_t crc = 0;
+  uint8_t header[DEVICETABLE_HEADER] = {DEVICETABLE_MAGIC, devices, parasite,
+                                        bitResolution};
+
+  for (uint8_t i = 0; i < DEVICETABLE_HEADER; i++) {
+    writer(offset++, header[i]);
+    crc = crc8Update(crc, header[i]);
+  }
+
+  for (uint8_t i = 0; i < cachedDeviceCount(); i++) {
+    DeviceEntry *entry = &deviceTable[i];
+    uint8_t record[DEVICETABLE_ENTRY];
+    memcpy(record, entry->address, sizeof(DeviceAddress));
+    record[8] = entry->resolution;
+    record[9] = entry->highAlarm;
+    record[10] = entry->lowAlarm;
+    record[11] = DEVICETABLE_NO_SLOT;
+    for (uint8_t slot = 0; slot < MAX31850_SLOTS; slot++) {
+      if (slotTable[slot] == i)
+        record[11] = slot;
+    }
+
+    for (uint8_t j = 0; j < DEVICETABLE_ENTRY; j++) {
+      writer(offset++, record[j]);
+      crc = crc8Update(crc, record[j]);
+    }
+  }
+  writer(offset, crc);
+}
+
+bool DallasTemperature::loadDeviceTable(DeviceTableReader *reader) {
+  uint16_t offset = 0;
+  uint8_t crc = 0;
+  uint8_t header[DEVICETABLE_HEADER];
+
+  for (uint8_t i = 0; i < DEVICETABLE_HEADER; i++) {
+    header[i] = reader(offset++);
+    crc = crc8Update(crc, header[i]);
+  }
+  devices = 0;
+  if (header[0] != DEVICETABLE_MAGIC)
+    return false;
+
+  uint8_t cached = min(header[1], (uint8_t)MAXDEVICES);
+  memset(slotTable, 0xFF, sizeof(slotTable));
+
+  for (uint8_t i = 0; i < cached; i++) {
+    DeviceEntry *entry = &deviceTable[i];
+    uint8_t record[DEVICETABLE_ENTRY];
+    for (uint8_t j = 0; j < DEVICETABLE_ENTRY; j++) {
+      record[j] = reader(offset++);
+      crc = crc8Update(crc, record[j]);
+    }
+
+    memcpy(entry->address, record, sizeof(DeviceAddress));
+    entry->resolution = record[8];
+    entry->highAlarm = record[9];
+    entry->lowAlarm = record[10];
+    entry->lastRaw = DEVICE_DISCONNECTED_RAW;
+    entry->newReading = false;
+    entry->verified = false;
+#if REQUIRESCHANGES
+    entry->reportedRaw = DEVICE_DISCONNECTED_RAW;
+    entry->deadband = 0;
+    entry->alarmArmed = false;
+#endif
+#if REQUIRESDISCOVERY
+    entry->seen = false;
+    entry->missing = false;
+#endif
+#if REQUIRESHEALTH
+    entry->failures = 0;
+    entry->skip = 0;
+#endif
+#if FILTERDEPTH
+    entry->sampleCount = 0;
+    entry->sampleNext = 0;
+#endif
+#if REQUIRESSTATS
+    entry->crcFailures = 0;
+#endif
+    if (record[11] < MAX31850_SLOTS && slotTable[record[11]] == 0xFF)
+      slotTable[record[11]] = i;
+  }
+
+  if (reader(offset) != crc) {
+    memset(slotTable, 0xFF, sizeof(slotTable));
+    return false;
+  }
+
+  devices = header[1];
+  parasite = header[2];
+  bitResolution = header[3];
+  unverifiedDevices = cached;
+  tableMismatch = false;
+#if REQUIRESDISCOVERY
+  discoveryActive = false;
+#endif
+  return true;
+}
+
+// the saved table replaces the power supply query, the search and the
+// scratchpad read of every device
+bool DallasTemperature::beginFast(DeviceTableReader *reader) {
+  if (loadDeviceTable(reader))
+    return true;
+  begin();
+  return false;
+}
+
+// a restored device that didn't answer as stored means the bus changed
+bool DallasTemperature::needsBegin(void) { return tableMismatch; }
+
 // returns the number of devices found on the bus
 uint8_t DallasTemperature::getDeviceCount(void) { return devices; }
 
+// returns the number of devices counted beyond the device table
+uint8_t DallasTemperature::getUntrackedDeviceCount(void) {
+  return devices - cachedDeviceCount();
+}
+
+#if REQUIRESCRCTABLE == 1
+// CRC8 (x^8 + x^5 + x^4 + 1) of every byte value
+static const uint8_t crc8Table[256] PROGMEM = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83,
+    0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E,
+    0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0,
+    0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D,
+    0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5,
+    0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58,
+    0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6,
+    0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B,
+    0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F,
+    0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92,
+    0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C,
+    0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1,
+    0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49,
+    0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4,
+    0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A,
+    0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7,
+    0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35,
+};
+#elif REQUIRESCRCTABLE == 2
+// CRC8 of the low and the high nibble of a byte, XORed together they give
+// the CRC8 of the whole byte
+static const uint8_t crc8LowTable[16] PROGMEM = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83,
+    0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+};
+static const uint8_t crc8HighTable[16] PROGMEM = {
+    0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8,
+    0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74,
+};
+#endif
+
+// adds one byte to a Dallas CRC8 with the REQUIRESCRCTABLE implementation,
+// for data that is never in one buffer such as the saved device table
+uint8_t DallasTemperature::crc8Update(uint8_t crc, uint8_t data) {
+  // the CRC8 of a byte continues a CRC8 if the byte is XORed with it first
+  data ^= crc;
+#if REQUIRESCRCTABLE == 1
+  return pgm_read_byte(&crc8Table[data]);
+#elif REQUIRESCRCTABLE == 2
+  return pgm_read_byte(&crc8LowTable[data & 0x0F]) ^
+         pgm_read_byte(&crc8HighTable[data >> 4]);
+#else
+  return OneWire::crc8(&data, 1);
+#endif
+}
+
+// Dallas CRC8 of ROM codes and scratchpads
+uint8_t DallasTemperature::crc8(const uint8_t *data, uint8_t length) {
+#if REQUIRESCRCTABLE
+  uint8_t crc = 0;
+  while (length--)
+    crc = crc8Update(crc, *data++);
+  return crc;
+#else
+  return OneWire::crc8((uint8_t *)data, length);
+#endif
+}
+
 // returns true if address is valid
 bool DallasTemperature::validAddress(uint8_t *deviceAddress) {
-  return (_wire->crc8(deviceAddress, 7) == deviceAddress[7]);
+  return (crc8(deviceAddress, 7) == deviceAddress[7]);
 }
 
 // finds an address at a given index on the bus
 // returns true if the device was found
 bool DallasTemperature::getAddress(uint8_t *deviceAddress, uint8_t index) {
+  // devices cached by begin() resolve without touching the bus
+  if (index < devices && index < MAXDEVICES) {
+    memcpy(deviceAddress, deviceTable[index].address, sizeof(DeviceAddress));
+    return true;
+  }
+
+  // not in the device table, walk the search tree
   uint8_t depth = 0;
 
   _wire->reset_search();
+#if REQUIRESDISCOVERY
+  // the walk reuses the search state, a discovery pass starts over
+  discoveryActive = false;
+#endif
 
-  while (depth <= index && _wire->search(deviceAddress)) {
-    if (depth == index && validAddress(deviceAddress))
+  while (depth <= index && searchBus(deviceAddress)) {
+    if (!validAddress(deviceAddress) || !MODEL_SUPPORTED(deviceAddress))
+      continue;
+    if (depth == index)
       return true;
     depth++;
   }
@@ -94,10 +540,26 @@ bool DallasTemperature::getAddress(uint8_t *deviceAddress, uint8_t index) {
   return false;
 }
 
+// returns the device table entry for an address, 0 if it is not cached
+DallasTemperature::DeviceEntry *
+DallasTemperature::findDevice(const uint8_t *deviceAddress) {
+  uint8_t cached = cachedDeviceCount();
+  for (uint8_t i = 0; i < cached; i++) {
+    if (!memcmp(deviceTable[i].address, deviceAddress, sizeof(DeviceAddress)))
+      return &deviceTable[i];
+  }
+  return 0;
+}
+
+// number of devices held in the device table
+uint8_t DallasTemperature::cachedDeviceCount(void) {
+  return min(devices, (uint8_t)MAXDEVICES);
+}
+
 // attempt to determine if the device at the given address is connected to the
 // bus
 bool DallasTemperature::isConnected(uint8_t *deviceAddress) {
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   return isConnected(deviceAddress, scratchPad);
 }
 
@@ -105,19 +567,48 @@ bool DallasTemperature::isConnected(uint8_t *deviceAddress) {
 // bus also allows for updating the read scratchpad
 bool DallasTemperature::isConnected(uint8_t *deviceAddress,
                                     uint8_t *scratchPad) {
-  readScratchPad(deviceAddress, scratchPad);
-  return (_wire->crc8(scratchPad, 8) == scratchPad[SCRATCHPAD_CRC]);
+  // a device that answered the reset is read again after a bad CRC, a missing
+  // one isn't
+  for (uint8_t attempt = 0;; attempt++) {
+    if (!readScratchPad(deviceAddress, scratchPad))
+      return false;
+    // running the CRC over the CRC byte as well leaves 0 for a valid
+    // scratchpad
+    if (crc8(scratchPad, sizeof(ScratchPad)) == 0)
+      return true;
+
+#if REQUIRESSTATS
+    stats.crcFailures++;
+    DeviceEntry *entry = findDevice(deviceAddress);
+    if (entry)
+      entry->crcFailures++;
+#endif
+    if (attempt >= retries)
+      return false;
+  }
 }
 
-// read device's scratch pad
-void DallasTemperature::readScratchPad(uint8_t *deviceAddress,
-                                       uint8_t *scratchPad) {
-  // send the command
-  _wire->reset();
+// read device's scratch pad, or only its first length bytes
+// returns false if no device answered the reset pulse
+bool DallasTemperature::readScratchPad(uint8_t *deviceAddress,
+                                       uint8_t *scratchPad, uint8_t length) {
+  // send MATCH ROM, the address and the command as one block, without the
+  // block buffer on the stack in low memory builds
+  STATS_START();
+  if (!resetBus())
+    return false;
+#if REQUIRESLOWMEMORY
   _wire->select(deviceAddress);
   _wire->write(READSCRATCH);
+#else
+  uint8_t command[10];
+  command[0] = MATCHROM;
+  memcpy(command + 1, deviceAddress, 8);
+  command[9] = READSCRATCH;
+  _wire->write_bytes(command, sizeof(command));
+#endif
 
-  // TODO => collect all comments &  use simple loop
+  // read the response
   // byte 0: temperature LSB
   // byte 1: temperature MSB
   // byte 2: high alarm temp
@@ -130,83 +621,133 @@ void DallasTemperature::readScratchPad(uint8_t *deviceAddress,
   // byte 7: DS18S20: COUNT_PER_C
   //         DS18B20 & DS1822: store for crc
   // byte 8: SCRATCHPAD_CRC
-  //
-  // for(int i=0; i<9; i++)
-  // {
-  //   scratchPad[i] = _wire->read();
-  // }
-
-  // read the response
-
-  // byte 0: temperature LSB
-  scratchPad[TEMP_LSB] = _wire->read();
-
-  // byte 1: temperature MSB
-  scratchPad[TEMP_MSB] = _wire->read();
-
-  // byte 2: high alarm temp
-  scratchPad[HIGH_ALARM_TEMP] = _wire->read();
-
-  // byte 3: low alarm temp
-  scratchPad[LOW_ALARM_TEMP] = _wire->read();
-
-  // byte 4:
-  // DS18S20: store for crc
-  // DS18B20 & DS1822: configuration register
-  scratchPad[CONFIGURATION] = _wire->read();
-
-  // byte 5:
-  // internal use & crc
-  scratchPad[INTERNAL_BYTE] = _wire->read();
-
-  // byte 6:
-  // DS18S20: COUNT_REMAIN
-  // DS18B20 & DS1822: store for crc
-  scratchPad[COUNT_REMAIN] = _wire->read();
+  if (length > sizeof(ScratchPad))
+    length = sizeof(ScratchPad);
+  _wire->read_bytes(scratchPad, length);
+
+  // the reset also ends a partial read
+  resetBus();
+  STATS_COUNT(scratchPadReads);
+  STATS_ADD(bus);
+  return true;
+}
 
-  // byte 7:
-  // DS18S20: COUNT_PER_C
-  // DS18B20 & DS1822: store for crc
-  scratchPad[COUNT_PER_C] = _wire->read();
+// reads the scratchpad bytes needed for a temperature. With partialRead the
+// transfer stops after the temperature and no CRC is checked
+bool DallasTemperature::readTempScratchPad(uint8_t *deviceAddress,
+                                           uint8_t *scratchPad) {
+  // devices restored by beginFast() get one CRC checked read first
+  if (unverifiedDevices) {
+    DeviceEntry *entry = findDevice(deviceAddress);
+    if (entry && !entry->verified) {
+      if (!isConnected(deviceAddress, scratchPad) ||
+          resolutionFromScratchPad(deviceAddress, scratchPad) !=
+              entry->resolution) {
+        tableMismatch = true;
+        return false;
+      }
+      entry->verified = true;
+      unverifiedDevices--;
+      return true;
+    }
+  }
 
-  // byte 8:
-  // SCTRACHPAD_CRC
-  scratchPad[SCRATCHPAD_CRC] = _wire->read();
+  if (!partialRead)
+    return isConnected(deviceAddress, scratchPad);
 
-  for (uint8_t i = 0; i < 8; i++) {
-    // Serial.print("\n 0x"); Serial.print(scratchPad[i], HEX);
+  DeviceEntry *entry;
+  switch (DEVICE_FAMILY(deviceAddress)) {
+  case DS18S20MODEL:
+    // extended resolution needs COUNT_REMAIN and COUNT_PER_C
+    return readScratchPad(deviceAddress, scratchPad, COUNT_PER_C + 1);
+  case DS18B20MODEL:
+  case DS1822MODEL:
+    // the resolution comes from the device table if the device is cached
+    entry = findDevice(deviceAddress);
+    if (entry == 0 || entry->resolution == 0)
+      return readScratchPad(deviceAddress, scratchPad, CONFIGURATION + 1);
+    scratchPad[CONFIGURATION] = resolutionToConfiguration(entry->resolution);
+    return readScratchPad(deviceAddress, scratchPad, TEMP_MSB + 1);
+  default:
+    // MAX31850 flags a fault in bit 0 of TEMP_LSB
+    return readScratchPad(deviceAddress, scratchPad, TEMP_MSB + 1);
   }
-  _wire->reset();
 }
 
 // writes device's scratch pad
 void DallasTemperature::writeScratchPad(uint8_t *deviceAddress,
                                         const uint8_t *scratchPad) {
-  _wire->reset();
-  _wire->select(deviceAddress);
-  _wire->write(WRITESCRATCH);
-  _wire->write(scratchPad[HIGH_ALARM_TEMP]); // high alarm temp
-  _wire->write(scratchPad[LOW_ALARM_TEMP]);  // low alarm temp
+  STATS_START();
+  uint8_t command[4];
+  command[0] = WRITESCRATCH;
+  command[1] = scratchPad[HIGH_ALARM_TEMP]; // high alarm temp
+  command[2] = scratchPad[LOW_ALARM_TEMP];  // low alarm temp
+  command[3] = scratchPad[CONFIGURATION];   // configuration
+
   // DS18S20 does not use the configuration register
-  if (deviceAddress[0] != DS18S20MODEL)
-    _wire->write(scratchPad[CONFIGURATION]); // configuration
-  _wire->reset();
+  uint8_t length = (DEVICE_FAMILY(deviceAddress) == DS18S20MODEL) ? 3 : 4;
+  selectDevice(deviceAddress);
+  _wire->write_bytes(command, length);
+
   // save the newly written values to eeprom
+  if (autoSaveScratchPad)
+    copyScratchPad(deviceAddress);
+  resetBus();
+
+  DeviceEntry *entry = findDevice(deviceAddress);
+  if (entry) {
+    entry->highAlarm = scratchPad[HIGH_ALARM_TEMP];
+    entry->lowAlarm = scratchPad[LOW_ALARM_TEMP];
+  }
+  STATS_ADD(bus);
+}
+
+// copies the scratchpad of a device, or of all devices for a 0 address, to
+// EEPROM
+void DallasTemperature::copyScratchPad(uint8_t *deviceAddress) {
+  selectDevice(deviceAddress);
   _wire->write(COPYSCRATCH, parasite);
   if (parasite)
     delay(10); // 10ms delay
-  _wire->reset();
+  resetBus();
+}
+
+// sends a reset pulse, returns 1 if a device answered with a presence pulse
+uint8_t DallasTemperature::resetBus(void) {
+  uint8_t present = _wire->reset();
+  STATS_COUNT(resets);
+  if (!present)
+    STATS_COUNT(presenceFailures);
+  return present;
+}
+
+// finds the next device of the ROM search
+uint8_t DallasTemperature::searchBus(uint8_t *deviceAddress) {
+  STATS_START();
+  uint8_t found = _wire->search(deviceAddress);
+  STATS_COUNT(searches);
+  STATS_ADD(bus);
+  return found;
+}
+
+// sends a reset followed by MATCH ROM, or SKIP ROM for a 0 address
+void DallasTemperature::selectDevice(uint8_t *deviceAddress) {
+  resetBus();
+  if (deviceAddress == 0)
+    _wire->skip();
+  else
+    _wire->select(deviceAddress);
 }
 
-// reads the device's power requirements
+// reads the device's power requirements, or those of every device on the bus
+// if deviceAddress is 0
 bool DallasTemperature::readPowerSupply(uint8_t *deviceAddress) {
   bool ret = false;
-  _wire->reset();
-  _wire->select(deviceAddress);
+  selectDevice(deviceAddress);
   _wire->write(READPOWERSUPPLY);
   if (_wire->read_bit() == 0)
     ret = true;
-  _wire->reset();
+  resetBus();
   return ret;
 }
 
@@ -214,71 +755,141 @@ bool DallasTemperature::readPowerSupply(uint8_t *deviceAddress) {
 // if new resolution is out of range, it is constrained.
 void DallasTemperature::setResolution(uint8_t newResolution) {
   bitResolution = constrain(newResolution, 9, 12);
-  DeviceAddress deviceAddress;
-  for (int i = 0; i < devices; i++) {
-    getAddress(deviceAddress, i);
-    setResolution(deviceAddress, bitResolution);
+
+  DeviceEntry *source = resolutionBroadcastSource();
+  if (source == 0) {
+    DeviceAddress deviceAddress;
+    for (int i = 0; i < devices; i++) {
+      getAddress(deviceAddress, i);
+      setResolution(deviceAddress, bitResolution);
+    }
+    return;
+  }
+
+  // every device takes the same TH, TL and configuration bytes
+  uint8_t command[4];
+  command[0] = WRITESCRATCH;
+  command[1] = source->highAlarm;                        // high alarm temp
+  command[2] = source->lowAlarm;                         // low alarm temp
+  command[3] = resolutionToConfiguration(bitResolution); // configuration
+  selectDevice(0);
+  _wire->write_bytes(command, sizeof(command));
+
+  // save the newly written values to eeprom
+  if (autoSaveScratchPad)
+    copyScratchPad(0);
+  resetBus();
+
+  for (uint8_t i = 0; i < devices; i++) {
+    if (DEVICE_FAMILY(deviceTable[i].address) != MAX31850MODEL)
+      deviceTable[i].resolution = bitResolution;
   }
 }
 
+// returns the device whose TH and TL can be broadcast with the new resolution
+// to every device in one WRITESCRATCH, or 0 if that isn't possible. Every
+// device must be cached, none may be a DS18S20 (which only takes TH and TL)
+// and all DS18B20/DS1822 must share the same TH and TL. MAX31850 ignores
+// WRITESCRATCH
+DallasTemperature::DeviceEntry *
+DallasTemperature::resolutionBroadcastSource(void) {
+  if (devices > MAXDEVICES)
+    return 0;
+
+  DeviceEntry *source = 0;
+  for (uint8_t i = 0; i < devices; i++) {
+    DeviceEntry *entry = &deviceTable[i];
+    if (DEVICE_FAMILY(entry->address) == MAX31850MODEL)
+      continue;
+    if (DEVICE_FAMILY(entry->address) == DS18S20MODEL ||
+        entry->resolution == 0)
+      return 0;
+    if (source == 0)
+      source = entry;
+    else if (entry->highAlarm != source->highAlarm ||
+             entry->lowAlarm != source->lowAlarm)
+      return 0;
+  }
+  return source;
+}
+
 // set resolution of a device to 9, 10, 11, or 12 bits
 // if new resolution is out of range, 9 bits is used.
 bool DallasTemperature::setResolution(uint8_t *deviceAddress,
                                       uint8_t newResolution) {
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad)) {
-    // DS18S20 has a fixed 9-bit resolution
-    if (deviceAddress[0] != DS18S20MODEL) {
-      switch (newResolution) {
-      case 12:
-        scratchPad[CONFIGURATION] = TEMP_12_BIT;
-        break;
-      case 11:
-        scratchPad[CONFIGURATION] = TEMP_11_BIT;
-        break;
-      case 10:
-        scratchPad[CONFIGURATION] = TEMP_10_BIT;
-        break;
-      case 9:
-      default:
-        scratchPad[CONFIGURATION] = TEMP_9_BIT;
-        break;
-      }
-      writeScratchPad(deviceAddress, scratchPad);
-    }
+    // DS18S20 has a fixed 9-bit resolution, MAX31850 a fixed 12-bit one
+    if (DEVICE_FAMILY(deviceAddress) == DS18S20MODEL ||
+        DEVICE_FAMILY(deviceAddress) == MAX31850MODEL)
+      return true;
+
+    scratchPad[CONFIGURATION] = resolutionToConfiguration(newResolution);
+    writeScratchPad(deviceAddress, scratchPad);
+
+    // cache what was written, out of range values were written as 9 bits
+    DeviceEntry *entry = findDevice(deviceAddress);
+    if (entry)
+      entry->resolution = resolutionFromScratchPad(deviceAddress, scratchPad);
     return true; // new value set
   }
   return false;
 }
 
+// returns the configuration register value for a resolution
+// if the resolution is out of range, 9 bits is used.
+uint8_t DallasTemperature::resolutionToConfiguration(uint8_t resolution) {
+  switch (resolution) {
+  case 12:
+    return TEMP_12_BIT;
+  case 11:
+    return TEMP_11_BIT;
+  case 10:
+    return TEMP_10_BIT;
+  case 9:
+  default:
+    return TEMP_9_BIT;
+  }
+}
+
 // returns the global resolution
 uint8_t DallasTemperature::getResolution() { return bitResolution; }
 
 // returns the current resolution of the device, 9-12
 // returns 0 if device not found
 uint8_t DallasTemperature::getResolution(uint8_t *deviceAddress) {
-  if (deviceAddress[0] == DS18S20MODEL)
+  if (DEVICE_FAMILY(deviceAddress) == DS18S20MODEL)
     return 9; // this model has a fixed resolution
 
-  ScratchPad scratchPad;
-  if (isConnected(deviceAddress, scratchPad)) {
-    switch (scratchPad[CONFIGURATION]) {
-    case TEMP_12_BIT:
-      return 12;
+  SCRATCHPAD(scratchPad);
+  if (isConnected(deviceAddress, scratchPad))
+    return resolutionFromScratchPad(deviceAddress, scratchPad);
+  return 0;
+}
 
-    case TEMP_11_BIT:
-      return 11;
+// decodes the resolution of a device from its scratchpad
+// returns 0 if the configuration register isn't recognised
+uint8_t DallasTemperature::resolutionFromScratchPad(uint8_t *deviceAddress,
+                                                    uint8_t *scratchPad) {
+  if (DEVICE_FAMILY(deviceAddress) == DS18S20MODEL)
+    return 9; // this model has a fixed resolution
 
-    case TEMP_10_BIT:
-      return 10;
+  switch (scratchPad[CONFIGURATION]) {
+  case TEMP_12_BIT:
+    return 12;
 
-    case TEMP_9_BIT:
-      return 9;
-    }
-    // special exception for MAX31850
-    if ((scratchPad[CONFIGURATION] & 0xF0) == 0xF0)
-      return 12;
+  case TEMP_11_BIT:
+    return 11;
+
+  case TEMP_10_BIT:
+    return 10;
+
+  case TEMP_9_BIT:
+    return 9;
   }
+  // special exception for MAX31850
+  if ((scratchPad[CONFIGURATION] & 0xF0) == 0xF0)
+    return 12;
   return 0;
 }
 
@@ -306,91 +917,263 @@ void DallasTemperature::setCheckForConversion(bool flag) {
 // gets the value of the waitForConversion flag
 bool DallasTemperature::getCheckForConversion() { return checkForConversion; }
 
+// sets the value of the autoSaveScratchPad flag
+// TRUE : scratchpad writes are copied to EEPROM and survive a power down
+// FALSE: scratchpad writes only change the volatile scratchpad
+void DallasTemperature::setAutoSaveScratchPad(bool flag) {
+  autoSaveScratchPad = flag;
+}
+
+// gets the value of the autoSaveScratchPad flag
+bool DallasTemperature::getAutoSaveScratchPad() { return autoSaveScratchPad; }
+
+// sets the value of the partialRead flag
+// TRUE : temperature reads stop after the temperature bytes, no CRC check
+// FALSE: temperature reads clock the whole scratchpad and check its CRC
+void DallasTemperature::setPartialRead(bool flag) { partialRead = flag; }
+
+// gets the value of the partialRead flag
+bool DallasTemperature::getPartialRead() { return partialRead; }
+
+// sets the number of extra reads of a scratchpad that failed its CRC
+void DallasTemperature::setRetries(uint8_t retries) {
+  this->retries = retries;
+}
+
+// gets the number of extra reads of a scratchpad that failed its CRC
+uint8_t DallasTemperature::getRetries() { return retries; }
+
+// Check if the clock has been raised indicating the conversion is complete
 bool DallasTemperature::isConversionAvailable(uint8_t *deviceAddress) {
-  // Check if the clock has been raised indicating the conversion is complete
-  ScratchPad scratchPad;
-  readScratchPad(deviceAddress, scratchPad);
-  return scratchPad[0];
+  return isConversionComplete();
+}
+
+// externally powered devices answer read time slots with 0 while converting
+// and 1 once done. Only valid directly after STARTCONVO without parasite power
+bool DallasTemperature::isConversionComplete(void) {
+  return _wire->read_bit() == 1;
 }
 
 // sends command for all devices on the bus to perform a temperature conversion
 void DallasTemperature::requestTemperatures() {
-  _wire->reset();
-  _wire->skip();
-  _wire->write(STARTCONVO, parasite);
+  startConversion();
 
   // ASYNC mode?
   if (!waitForConversion)
     return;
-  blockTillConversionComplete(&bitResolution, 0);
+  blockTillConversionComplete(bitResolution);
+  conversionState = CONVERSION_READY;
 
   return;
 }
 
+// sends command for all devices on the bus to perform a temperature conversion
+// and returns immediately, poll() tracks it from there
+void DallasTemperature::startConversion(void) {
+  resetBus();
+  _wire->skip();
+  _wire->write(STARTCONVO, parasite);
+  STATS_COUNT(conversions);
+
+  conversionStart = millis();
+  conversionIndex = 0;
+  conversionState = CONVERSION_CONVERTING;
+}
+
+// the caller has waited for the conversion, poll() starts reading
+void DallasTemperature::finishConversion(void) {
+  if (conversionState == CONVERSION_CONVERTING)
+    conversionState = CONVERSION_READY;
+}
+
+// advances the non-blocking conversion, reading one device per call once the
+// conversion is complete
+DallasTemperature::ConversionState DallasTemperature::poll(void) {
+  switch (conversionState) {
+  case CONVERSION_CONVERTING:
+    // externally powered devices hold the bus low while converting, parasite
+    // powered ones need the strong pullup so wait the worst case time
+    if ((checkForConversion && !parasite && isConversionComplete()) ||
+        (millis() - conversionStart) >=
+            millisToWaitForConversion(bitResolution))
+      conversionState = CONVERSION_READY;
+    break;
+
+  case CONVERSION_READY:
+    conversionIndex = 0;
+    conversionState = CONVERSION_READING;
+    // fall through
+
+  case CONVERSION_READING:
+    if (conversionIndex < cachedDeviceCount())
+      readDeviceTemperature(conversionIndex++);
+    if (conversionIndex >= cachedDeviceCount()) {
+      conversionState = CONVERSION_DONE;
+#if REQUIRESDISCOVERY
+      // the bus is free until the next conversion
+      if (discovery)
+        discoveryStep();
+#endif
+    }
+    break;
+
+  default:
+#if REQUIRESDISCOVERY
+    if (discovery)
+      discoveryStep();
+#endif
+    break;
+  }
+  return conversionState;
+}
+
+// runs the per-resolution scheduler: every resolution group is read once its
+// own conversion time has passed and then started again, so fast groups are
+// sampled while slow ones are still converting
+// returns the number of devices read by this call
+uint8_t DallasTemperature::pollScheduler(void) {
+  // the strong pullup holds the bus for the whole conversion, so parasite
+  // powered devices can only be converted together
+  if (parasite) {
+    // poll() only reads while READY or READING, READY starts from device 0
+    ConversionState before = conversionState;
+    uint8_t index = (before == CONVERSION_READING) ? conversionIndex : 0;
+    ConversionState state = poll();
+    uint8_t read = 0;
+    if (before == CONVERSION_READY || before == CONVERSION_READING)
+      read = conversionIndex - index;
+    if (state == CONVERSION_IDLE || state == CONVERSION_DONE)
+      startConversion();
+    return read;
+  }
+
+  uint8_t cached = cachedDeviceCount();
+  uint8_t read = 0;
+
+  for (uint8_t resolution = 9; resolution <= 12; resolution++) {
+    uint8_t group = resolution - 9;
+
+    if (groupsConverting & (1 << group)) {
+      if ((millis() - groupStart[group]) <
+          millisToWaitForConversion(resolution))
+        continue;
+
+      for (uint8_t i = 0; i < cached; i++) {
+        if (conversionResolution(i) == resolution) {
+          readDeviceTemperature(i);
+          read++;
+        }
+      }
+      groupsConverting &= ~(1 << group);
+    }
+
+    // (re)start the group, STARTCONVO can only address one device or all
+    bool started = false;
+    for (uint8_t i = 0; i < cached; i++) {
+      if (conversionResolution(i) == resolution) {
+        selectDevice(deviceTable[i].address);
+        _wire->write(STARTCONVO);
+        STATS_COUNT(conversions);
+        started = true;
+      }
+    }
+    if (started) {
+      resetBus();
+      groupStart[group] = millis();
+      groupsConverting |= (1 << group);
+    }
+  }
+  return read;
+}
+
+// returns the resolution a cached device converts at, devices of unknown
+// resolution get the worst case
+uint8_t DallasTemperature::conversionResolution(uint8_t deviceIndex) {
+  uint8_t resolution = deviceTable[deviceIndex].resolution;
+  return resolution ? resolution : 12;
+}
+
+// returns the worst case conversion time for a resolution (based on IC
+// datasheet)
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t bitResolution) {
+  switch (bitResolution) {
+  case 9:
+    return 94;
+  case 10:
+    return 188;
+  case 11:
+    return 375;
+  case 12:
+  default:
+    return 750;
+  }
+}
+
 // sends command for one device to perform a temperature by address
 // returns FALSE if device is disconnected
 // returns TRUE  otherwise
 bool DallasTemperature::requestTemperaturesByAddress(uint8_t *deviceAddress) {
 
-  _wire->reset();
+  // the resolution of cached devices is known without reading the scratchpad
+  DeviceEntry *entry = findDevice(deviceAddress);
+  uint8_t bitResolution = entry ? entry->resolution : 0;
+  if (bitResolution == 0) {
+    bitResolution = getResolution(deviceAddress);
+    if (bitResolution == 0)
+      return false;
+  }
+
+  // no presence pulse, nothing on the bus
+  if (!resetBus())
+    return false;
   _wire->select(deviceAddress);
   _wire->write(STARTCONVO, parasite);
+  STATS_COUNT(conversions);
 
-  // check device
-  ScratchPad scratchPad;
-  if (!isConnected(deviceAddress, scratchPad))
+  // check device: an externally powered device answers the first read time
+  // slot with 0 while it is converting, 1 means nobody started a conversion
+  if (!parasite && isConversionComplete())
     return false;
 
   // ASYNC mode?
   if (!waitForConversion)
     return true;
-  uint8_t bitResolution = getResolution(deviceAddress);
-  blockTillConversionComplete(&bitResolution, deviceAddress);
+  blockTillConversionComplete(bitResolution);
 
   return true;
 }
 
-void DallasTemperature::blockTillConversionComplete(uint8_t *bitResolution,
-                                                    uint8_t *deviceAddress) {
-  if (deviceAddress != 0 && checkForConversion && !parasite) {
-    // Continue to check if the IC has responded with a temperature
-    // NB: Could cause issues with multiple devices (one device may respond
-    // faster)
+void DallasTemperature::blockTillConversionComplete(uint8_t bitResolution) {
+  uint16_t conversionTime = millisToWaitForConversion(bitResolution);
+  STATS_START();
+
+  if (checkForConversion && !parasite) {
+    // Poll read time slots until every converting device releases the bus,
+    // no reset or other traffic may happen since STARTCONVO
     unsigned long start = millis();
-    while (!isConversionAvailable(0) && ((millis() - start) < 750))
+    while (!isConversionComplete() && ((millis() - start) < conversionTime))
       ;
+  } else {
+    // Wait a fix number of cycles till conversion is complete (based on IC
+    // datasheet)
+    delay(conversionTime);
   }
-
-  // Wait a fix number of cycles till conversion is complete (based on IC
-  // datasheet)
-  switch (*bitResolution) {
-  case 9:
-    delay(94);
-    break;
-  case 10:
-    delay(188);
-    break;
-  case 11:
-    delay(375);
-    break;
-  case 12:
-  default:
-    delay(750);
-    break;
-  }
+  STATS_ADD(conversionWait);
 }
 
 // sends command for one device to perform a temp conversion by index
 bool DallasTemperature::requestTemperaturesByIndex(uint8_t deviceIndex) {
   DeviceAddress deviceAddress;
-  getAddress(deviceAddress, deviceIndex);
+  if (!getAddress(deviceAddress, deviceIndex))
+    return false;
   return requestTemperaturesByAddress(deviceAddress);
 }
 
 // Fetch temperature for device index
 float DallasTemperature::getTempCByIndex(uint8_t deviceIndex) {
   DeviceAddress deviceAddress;
-  getAddress(deviceAddress, deviceIndex);
+  if (!getAddress(deviceAddress, deviceIndex))
+    return DEVICE_DISCONNECTED;
   return getTempC((uint8_t *)deviceAddress);
 }
 
@@ -399,35 +1182,326 @@ float DallasTemperature::getTempFByIndex(uint8_t deviceIndex) {
   return toFahrenheit(getTempCByIndex(deviceIndex));
 }
 
-// reads scratchpad and returns the temperature in degrees C
-float DallasTemperature::calculateTemperature(uint8_t *deviceAddress,
-                                              uint8_t *scratchPad) {
+// reads the temperature of every cached device with one scratchpad read each
+// returns the number of temperatures read successfully
+uint8_t DallasTemperature::readAllTempsC(float *temps, uint8_t maxTemps) {
+  uint8_t count = min(cachedDeviceCount(), maxTemps);
+  uint8_t valid = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    int16_t raw = readDeviceTemperature(i);
+    temps[i] = rawToCelsius(raw);
+    if (raw != DEVICE_DISCONNECTED_RAW && raw != DEVICE_FAULT_RAW) {
+#if FILTERDEPTH
+      temps[i] = filteredValue(&deviceTable[i]) / 256.0;
+#endif
+      valid++;
+    }
+  }
+  return valid;
+}
+
+// reads the raw temperature of every cached device with one scratchpad read
+// each, returns the number of temperatures read successfully
+uint8_t DallasTemperature::readAllTempsRaw(int16_t *temps, uint8_t maxTemps) {
+  uint8_t count = min(cachedDeviceCount(), maxTemps);
+  uint8_t valid = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    temps[i] = readDeviceTemperature(i);
+    if (temps[i] != DEVICE_DISCONNECTED_RAW && temps[i] != DEVICE_FAULT_RAW) {
+#if FILTERDEPTH
+      temps[i] = filteredRaw(i);
+#endif
+      valid++;
+    }
+  }
+  return valid;
+}
+
+// looks up the MAX31850 at an AD3-AD0 location
+bool DallasTemperature::getAddressBySlot(uint8_t *deviceAddress,
+                                         uint8_t slot) {
+  if (slot >= MAX31850_SLOTS || slotTable[slot] == 0xFF)
+    return false;
+  memcpy(deviceAddress, deviceTable[slotTable[slot]].address,
+         sizeof(DeviceAddress));
+  return true;
+}
+
+// reads the MAX31850 at an AD3-AD0 location in degrees C
+float DallasTemperature::getTempCBySlot(uint8_t slot) {
+  return rawToCelsius(getTempRawBySlot(slot));
+}
+
+// reads the MAX31850 at an AD3-AD0 location in 1/16 degrees C
+int16_t DallasTemperature::getTempRawBySlot(uint8_t slot) {
+  if (slot >= MAX31850_SLOTS || slotTable[slot] == 0xFF)
+    return DEVICE_DISCONNECTED_RAW;
+  return readDeviceTemperature(slotTable[slot]);
+}
+
+// reads every occupied slot, temps is indexed by location
+uint8_t DallasTemperature::readAllTempsCBySlot(float *temps, uint8_t maxTemps) {
+  uint8_t count = min(maxTemps, (uint8_t)MAX31850_SLOTS);
+  uint8_t valid = 0;
+
+  for (uint8_t slot = 0; slot < count; slot++) {
+    int16_t raw = getTempRawBySlot(slot);
+    temps[slot] = rawToCelsius(raw);
+    if (raw != DEVICE_DISCONNECTED_RAW && raw != DEVICE_FAULT_RAW)
+      valid++;
+  }
+  return valid;
+}
+
+// reads a cached device and stores its raw temperature in the device table
+int16_t DallasTemperature::readDeviceTemperature(uint8_t deviceIndex) {
+  DeviceEntry *entry = &deviceTable[deviceIndex];
+  SCRATCHPAD(scratchPad);
+
+#if REQUIRESHEALTH
+  // a failing device is skipped, so its timeouts don't slow every sweep
+  if (entry->skip) {
+    entry->skip--;
+    entry->lastRaw = DEVICE_DISCONNECTED_RAW;
+    return entry->lastRaw;
+  }
+#endif
+
+  if (readTempScratchPad(entry->address, scratchPad)) {
+    entry->lastRaw = calculateRawTemperature(entry->address, scratchPad);
+#if REQUIRESHEALTH
+    entry->failures = 0;
+#endif
+#if FILTERDEPTH
+    if (entry->lastRaw != DEVICE_FAULT_RAW)
+      addSample(entry, entry->lastRaw);
+#endif
+  } else {
+    entry->lastRaw = DEVICE_DISCONNECTED_RAW;
+#if REQUIRESHEALTH
+    if (entry->failures < 255)
+      entry->failures++;
+#if SKIPAFTERFAILURES
+    // skip 1, 2, 4 ... 32 reads between probes
+    if (entry->failures >= SKIPAFTERFAILURES) {
+      uint8_t backoff = entry->failures - SKIPAFTERFAILURES;
+      entry->skip = 1 << (backoff < 5 ? backoff : 5);
+    }
+#endif
+#endif
+  }
+  entry->newReading = true;
+  return entry->lastRaw;
+}
+
+#if REQUIRESHEALTH
+
+// returns the failed reads in a row of a cached device
+uint8_t DallasTemperature::getFailuresByIndex(uint8_t deviceIndex) {
+  if (deviceIndex >= cachedDeviceCount())
+    return 0;
+  return deviceTable[deviceIndex].failures;
+}
+
+#endif
+
+// returns true once for every new reading of a cached device
+bool DallasTemperature::hasNewReading(uint8_t deviceIndex) {
+  if (deviceIndex >= cachedDeviceCount())
+    return false;
+  if (!deviceTable[deviceIndex].newReading)
+    return false;
+  deviceTable[deviceIndex].newReading = false;
+  return true;
+}
+
+#if REQUIRESCHANGES
+
+// sets the change handler
+void DallasTemperature::setChangeHandler(ChangeHandler *handler) {
+  _ChangeHandler = handler;
+}
+
+// sets the deadband of a cached device in 1/16 degrees C
+bool DallasTemperature::setDeadband(uint8_t deviceIndex, uint8_t deadband) {
+  if (deviceIndex >= cachedDeviceCount())
+    return false;
+  deviceTable[deviceIndex].deadband = deadband;
+  return true;
+}
+
+// returns the deadband of a cached device in 1/16 degrees C
+uint8_t DallasTemperature::getDeadband(uint8_t deviceIndex) {
+  if (deviceIndex >= cachedDeviceCount())
+    return 0;
+  return deviceTable[deviceIndex].deadband;
+}
+
+// reads every cached device and reports the ones that moved past their
+// deadband
+uint8_t DallasTemperature::readChanged(void) {
+  uint8_t reported = 0;
+
+  for (uint8_t i = 0; i < cachedDeviceCount(); i++) {
+    if (reportChange(i))
+      reported++;
+    // the scratchpads may have been reloaded from EEPROM
+    deviceTable[i].alarmArmed = false;
+  }
+  return reported;
+}
+
+// reads a cached device and reports it if it moved past its deadband, error
+// codes are reported once when they first show up
+bool DallasTemperature::reportChange(uint8_t deviceIndex) {
+  DeviceEntry *entry = &deviceTable[deviceIndex];
+  int16_t raw = readDeviceTemperature(deviceIndex);
+  bool rawValid = raw != DEVICE_DISCONNECTED_RAW && raw != DEVICE_FAULT_RAW;
+  bool reportedValid = entry->reportedRaw != DEVICE_DISCONNECTED_RAW &&
+                       entry->reportedRaw != DEVICE_FAULT_RAW;
+
+  bool changed;
+  if (rawValid && reportedValid) {
+    int32_t delta = (int32_t)raw - entry->reportedRaw;
+    if (delta < 0)
+      delta = -delta;
+    changed = delta > entry->deadband;
+  } else
+    changed = raw != entry->reportedRaw;
+
+  if (!changed)
+    return false;
+  entry->reportedRaw = raw;
+  if (_ChangeHandler)
+    _ChangeHandler(entry->address, raw);
+  return true;
+}
+
+#endif
+
+// returns the last raw temperature read for a cached device
+int16_t DallasTemperature::getLastTempRawByIndex(uint8_t deviceIndex) {
+  if (deviceIndex >= cachedDeviceCount())
+    return DEVICE_DISCONNECTED_RAW;
+  return deviceTable[deviceIndex].lastRaw;
+}
+
+// returns the last temperature read for a cached device in degrees C
+float DallasTemperature::getLastTempCByIndex(uint8_t deviceIndex) {
+  return rawToCelsius(getLastTempRawByIndex(deviceIndex));
+}
+
+#if FILTERDEPTH
+
+// sets the filter of the bulk reads
+void DallasTemperature::setFilter(FilterType type) { filter = type; }
+
+// gets the filter of the bulk reads
+DallasTemperature::FilterType DallasTemperature::getFilter(void) {
+  return filter;
+}
+
+// returns the filtered temperature of a cached device in degrees C
+float DallasTemperature::getFilteredTempCByIndex(uint8_t deviceIndex) {
+  int16_t raw = getLastTempRawByIndex(deviceIndex);
+  if (raw == DEVICE_DISCONNECTED_RAW || raw == DEVICE_FAULT_RAW)
+    return rawToCelsius(raw);
+  return filteredValue(&deviceTable[deviceIndex]) / 256.0;
+}
+
+// adds a raw temperature to the ring and the exponential average of a device
+void DallasTemperature::addSample(DeviceEntry *entry, int16_t raw) {
+  int32_t value = (int32_t)raw * 16;
+  if (entry->sampleCount == 0)
+    entry->average = value;
+  else
+    entry->average += (value - entry->average) * 2 / (FILTERDEPTH + 1);
+
+  entry->samples[entry->sampleNext] = raw;
+  entry->sampleNext = (entry->sampleNext + 1) % FILTERDEPTH;
+  if (entry->sampleCount < FILTERDEPTH)
+    entry->sampleCount++;
+}
+
+// filters the samples of a device, the result keeps 4 extra fraction bits
+// so averages of coarse samples aren't rounded back to 1/16 degrees C
+int32_t DallasTemperature::filteredValue(const DeviceEntry *entry) {
+  uint8_t last = (entry->sampleNext + FILTERDEPTH - 1) % FILTERDEPTH;
+  int32_t sum = 0;
+
+  switch (filter) {
+  case FILTER_AVERAGE:
+    for (uint8_t i = 0; i < entry->sampleCount; i++)
+      sum += entry->samples[i];
+    return sum * 16 / entry->sampleCount;
+  case FILTER_EMA:
+    return entry->average;
+  case FILTER_MEDIAN3:
+    if (entry->sampleCount >= 3) {
+      int16_t a = entry->samples[last];
+      int16_t b = entry->samples[(last + FILTERDEPTH - 1) % FILTERDEPTH];
+      int16_t c = entry->samples[(last + FILTERDEPTH - 2) % FILTERDEPTH];
+      // the median is whichever value isn't the smallest or the largest
+      int16_t median = max(min(a, b), min(max(a, b), c));
+      return (int32_t)median * 16;
+    }
+    if (entry->sampleCount == 2) {
+      sum = entry->samples[last];
+      sum += entry->samples[(last + FILTERDEPTH - 1) % FILTERDEPTH];
+      return sum * 8;
+    }
+    return (int32_t)entry->samples[last] * 16;
+  default:
+    return (int32_t)entry->samples[last] * 16;
+  }
+}
+
+// returns the filtered temperature of a device rounded to 1/16 degrees C
+int16_t DallasTemperature::filteredRaw(uint8_t deviceIndex) {
+  int32_t value = filteredValue(&deviceTable[deviceIndex]);
+  if (value < 0)
+    return -((8 - value) / 16);
+  return (value + 8) / 16;
+}
+
+#endif
+
+// converts a raw temperature, including its error codes, to degrees C
+float DallasTemperature::rawToCelsius(int16_t raw) {
+  if (raw == DEVICE_DISCONNECTED_RAW)
+    return DEVICE_DISCONNECTED;
+  if (raw == DEVICE_FAULT_RAW)
+    return NAN;
+  return (float)raw * 0.0625;
+}
+
+// reads scratchpad and returns the temperature in 1/16 degrees C, the
+// resolution of the DS18B20 at 12 bits. Only uses integer shifts and masks
+int16_t DallasTemperature::calculateRawTemperature(uint8_t *deviceAddress,
+                                                   uint8_t *scratchPad) {
   int16_t rawTemperature =
       (((int16_t)scratchPad[TEMP_MSB]) << 8) | scratchPad[TEMP_LSB];
 
-  switch (deviceAddress[0]) {
+  switch (DEVICE_FAMILY(deviceAddress)) {
   case MAX31850MODEL:
-    if (scratchPad[0] & 0x1) {
-      return NAN;
-    } else {
-      return (float)rawTemperature * 0.0625;
-    }
-    break;
+    // bit 0 is the fault flag, bit 1 is reserved
+    if (rawTemperature & 0x1)
+      return DEVICE_FAULT_RAW;
+    return rawTemperature & ~0x3;
   case DS18B20MODEL:
   case DS1822MODEL:
+    // the low bits are undefined at lower resolutions
     switch (scratchPad[CONFIGURATION]) {
     case TEMP_12_BIT:
-      return (float)rawTemperature * 0.0625;
-      break;
+      return rawTemperature;
     case TEMP_11_BIT:
-      return (float)(rawTemperature >> 1) * 0.125;
-      break;
+      return rawTemperature & ~0x1;
     case TEMP_10_BIT:
-      return (float)(rawTemperature >> 2) * 0.25;
-      break;
+      return rawTemperature & ~0x3;
     case TEMP_9_BIT:
-      return (float)(rawTemperature >> 3) * 0.5;
-      break;
+      return rawTemperature & ~0x7;
     }
     break;
   case DS18S20MODEL:
@@ -447,12 +1521,19 @@ float DallasTemperature::calculateTemperature(uint8_t *deviceAddress,
     */
 
     // Good spot. Thanks Nic Johns for your contribution
-    return (float)(rawTemperature >> 1) - 0.25 +
-           ((float)(scratchPad[COUNT_PER_C] - scratchPad[COUNT_REMAIN]) /
-            (float)scratchPad[COUNT_PER_C]);
-    break;
+    if (scratchPad[COUNT_PER_C] == 0)
+      return rawTemperature * 8;
+    return (rawTemperature >> 1) * 16 - 4 +
+           ((scratchPad[COUNT_PER_C] - scratchPad[COUNT_REMAIN]) * 16) /
+               scratchPad[COUNT_PER_C];
   }
-  return NAN;
+  return DEVICE_FAULT_RAW;
+}
+
+// reads scratchpad and returns the temperature in degrees C
+float DallasTemperature::calculateTemperature(uint8_t *deviceAddress,
+                                              uint8_t *scratchPad) {
+  return rawToCelsius(calculateRawTemperature(deviceAddress, scratchPad));
 }
 
 // returns temperature in degrees C or DEVICE_DISCONNECTED if the
@@ -461,14 +1542,104 @@ float DallasTemperature::calculateTemperature(uint8_t *deviceAddress,
 // DallasTemperature.h. It is a large negative number outside the
 // operating range of the device
 float DallasTemperature::getTempC(uint8_t *deviceAddress) {
+  return rawToCelsius(getTempRaw(deviceAddress));
+}
+
+// returns temperature in 1/16 degrees C, DEVICE_DISCONNECTED_RAW if the
+// device's scratch pad cannot be read successfully or DEVICE_FAULT_RAW on a
+// sensor fault
+int16_t DallasTemperature::getTempRaw(uint8_t *deviceAddress) {
   // TODO: Multiple devices (up to 64) on the same bus may take
   //       some time to negotiate a response
   // What happens in case of collision?
 
-  ScratchPad scratchPad;
-  if (isConnected(deviceAddress, scratchPad))
-    return calculateTemperature(deviceAddress, scratchPad);
-  return DEVICE_DISCONNECTED;
+  SCRATCHPAD(scratchPad);
+  if (readTempScratchPad(deviceAddress, scratchPad))
+    return calculateRawTemperature(deviceAddress, scratchPad);
+  return DEVICE_DISCONNECTED_RAW;
+}
+
+// returns temperature in 1/1000 degrees C, DEVICE_DISCONNECTED_MILLIC or
+// DEVICE_FAULT_MILLIC on errors
+int32_t DallasTemperature::getTempMilliC(uint8_t *deviceAddress) {
+  int16_t raw = getTempRaw(deviceAddress);
+  if (raw == DEVICE_DISCONNECTED_RAW)
+    return DEVICE_DISCONNECTED_MILLIC;
+  if (raw == DEVICE_FAULT_RAW)
+    return DEVICE_FAULT_MILLIC;
+  // 1000 / 16 = 125 / 2
+  return ((int32_t)raw * 125) / 2;
+}
+
+// returns temperature in 1/100 degrees C, DEVICE_DISCONNECTED_RAW or
+// DEVICE_FAULT_RAW on errors. Temperatures above 327.67 C saturate
+int16_t DallasTemperature::getTempCentiC(uint8_t *deviceAddress) {
+  int16_t raw = getTempRaw(deviceAddress);
+  if (raw == DEVICE_DISCONNECTED_RAW || raw == DEVICE_FAULT_RAW)
+    return raw;
+  // 100 / 16 = 25 / 4
+  int32_t centi = ((int32_t)raw * 25) / 4;
+  if (centi > 32767)
+    return 32767;
+  return (int16_t)centi;
+}
+
+// reads and decodes the whole scratchpad of a MAX31850
+bool DallasTemperature::readMAX31850(uint8_t *deviceAddress,
+                                     Max31850Reading *reading) {
+  SCRATCHPAD(scratchPad);
+  if (DEVICE_FAMILY(deviceAddress) != MAX31850MODEL ||
+      !isConnected(deviceAddress, scratchPad))
+    return false;
+  decodeMAX31850(scratchPad, reading);
+
+  DeviceEntry *entry = findDevice(deviceAddress);
+  if (entry) {
+    entry->lastRaw = reading->thermocouple;
+    entry->newReading = true;
+  }
+  return true;
+}
+
+// reads every cached MAX31850 in device table order
+uint8_t DallasTemperature::readAllMAX31850(Max31850Reading *readings,
+                                           uint8_t maxReadings) {
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < cachedDeviceCount() && count < maxReadings; i++) {
+    if (DEVICE_FAMILY(deviceTable[i].address) != MAX31850MODEL)
+      continue;
+
+    // a failed read keeps its entry, so later entries don't shift
+    Max31850Reading *reading = &readings[count++];
+    if (readMAX31850(deviceTable[i].address, reading))
+      continue;
+    reading->thermocouple = DEVICE_DISCONNECTED_RAW;
+    reading->coldJunction = DEVICE_DISCONNECTED_RAW;
+    reading->faults = 0;
+    reading->location = 0xFF;
+    for (uint8_t slot = 0; slot < MAX31850_SLOTS; slot++) {
+      if (slotTable[slot] == i)
+        reading->location = slot;
+    }
+  }
+  return count;
+}
+
+// thermocouple: 14 bits in 0.25C with the fault flag in bit 0
+// cold junction: 12 bits in 1/16C with the fault bits below them
+void DallasTemperature::decodeMAX31850(const uint8_t *scratchPad,
+                                       Max31850Reading *reading) {
+  int16_t thermocouple =
+      (((int16_t)scratchPad[TEMP_MSB]) << 8) | scratchPad[TEMP_LSB];
+  int16_t coldJunction = (((int16_t)scratchPad[MAX31850_CJ_MSB]) << 8) |
+                         scratchPad[MAX31850_CJ_LSB];
+
+  reading->faults = scratchPad[MAX31850_CJ_LSB] & 0x07;
+  reading->thermocouple =
+      (thermocouple & 0x1) ? DEVICE_FAULT_RAW : (thermocouple & ~0x3);
+  reading->coldJunction = coldJunction >> 4;
+  reading->location = scratchPad[MAX31850_ADDRESS] & 0x0F;
 }
 
 // returns temperature in degrees F
@@ -513,7 +1684,7 @@ void DallasTemperature::setHighAlarmTemp(uint8_t *deviceAddress, char celsius) {
   else if (celsius < -55)
     celsius = -55;
 
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad)) {
     scratchPad[HIGH_ALARM_TEMP] = (uint8_t)celsius;
     writeScratchPad(deviceAddress, scratchPad);
@@ -530,7 +1701,7 @@ void DallasTemperature::setLowAlarmTemp(uint8_t *deviceAddress, char celsius) {
   else if (celsius < -55)
     celsius = -55;
 
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad)) {
     scratchPad[LOW_ALARM_TEMP] = (uint8_t)celsius;
     writeScratchPad(deviceAddress, scratchPad);
@@ -540,7 +1711,7 @@ void DallasTemperature::setLowAlarmTemp(uint8_t *deviceAddress, char celsius) {
 // returns a char with the current high alarm temperature or
 // DEVICE_DISCONNECTED for an address
 char DallasTemperature::getHighAlarmTemp(uint8_t *deviceAddress) {
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad))
     return (char)scratchPad[HIGH_ALARM_TEMP];
   return DEVICE_DISCONNECTED;
@@ -549,7 +1720,7 @@ char DallasTemperature::getHighAlarmTemp(uint8_t *deviceAddress) {
 // returns a char with the current low alarm temperature or
 // DEVICE_DISCONNECTED for an address
 char DallasTemperature::getLowAlarmTemp(uint8_t *deviceAddress) {
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad))
     return (char)scratchPad[LOW_ALARM_TEMP];
   return DEVICE_DISCONNECTED;
@@ -582,8 +1753,12 @@ bool DallasTemperature::alarmSearch(uint8_t *newAddr) {
 
   if (alarmSearchExhausted)
     return false;
-  if (!_wire->reset())
+  STATS_START();
+  if (!resetBus()) {
+    STATS_ADD(bus);
     return false;
+  }
+  STATS_COUNT(searches);
 
   // send the alarm search command
   _wire->write(0xEC, 0);
@@ -596,8 +1771,10 @@ bool DallasTemperature::alarmSearch(uint8_t *newAddr) {
 
     // I don't think this should happen, this means nothing responded, but maybe
     // if something vanishes during the search it will come up.
-    if (a && nota)
+    if (a && nota) {
+      STATS_ADD(bus);
       return false;
+    }
 
     if (!a && !nota) {
       if (i == alarmSearchJunction) {
@@ -634,6 +1811,7 @@ bool DallasTemperature::alarmSearch(uint8_t *newAddr) {
     _wire->write_bit(a);
   }
 
+  STATS_ADD(bus);
   if (done)
     alarmSearchExhausted = 1;
   for (i = 0; i < 8; i++)
@@ -641,22 +1819,40 @@ bool DallasTemperature::alarmSearch(uint8_t *newAddr) {
   return true;
 }
 
+// collects every device that answers the alarm search. Each device still
+// costs a reset and a conditional search pass, that is how the search works
+uint8_t DallasTemperature::alarmSearchAll(DeviceAddress *alarms,
+                                          uint8_t maxAlarms) {
+  uint8_t count = 0;
+
+  resetAlarmSearch();
+  while (count < maxAlarms && alarmSearch(alarms[count])) {
+    if (validAddress(alarms[count]))
+      count++;
+  }
+  return count;
+}
+
 // returns true if device address has an alarm condition
-// TODO: can this be done with only TEMP_MSB REGISTER (faster)
-//       if ((char) scratchPad[TEMP_MSB] <= (char) scratchPad[LOW_ALARM_TEMP])
-//       return true; if ((char) scratchPad[TEMP_MSB] >= (char)
-//       scratchPad[HIGH_ALARM_TEMP]) return true;
+// the devices compare TH and TL with the whole degrees of the temperature
+// register, so the same integer compare is done here without a conversion
 bool DallasTemperature::hasAlarm(uint8_t *deviceAddress) {
-  ScratchPad scratchPad;
+  SCRATCHPAD(scratchPad);
   if (isConnected(deviceAddress, scratchPad)) {
-    float temp = calculateTemperature(deviceAddress, scratchPad);
+    int16_t raw = (((int16_t)scratchPad[TEMP_MSB]) << 8) |
+                  scratchPad[TEMP_LSB];
+
+    // DS18S20 counts in 0.5C, the others in 1/16C
+    int8_t temp = (int8_t)((DEVICE_FAMILY(deviceAddress) == DS18S20MODEL)
+                               ? raw >> 1
+                               : raw >> 4);
 
     // check low alarm
-    if ((char)temp <= (char)scratchPad[LOW_ALARM_TEMP])
+    if (temp <= (int8_t)scratchPad[LOW_ALARM_TEMP])
       return true;
 
     // check high alarm
-    if ((char)temp >= (char)scratchPad[HIGH_ALARM_TEMP])
+    if (temp >= (int8_t)scratchPad[HIGH_ALARM_TEMP])
       return true;
   }
 
@@ -682,6 +1878,75 @@ void DallasTemperature::processAlarms(void) {
   }
 }
 
+#if REQUIRESCHANGES
+
+// reads the devices found by one alarm search, plus those without an alarm
+// window, and reports the ones that moved past their deadband
+uint8_t DallasTemperature::readChangedByAlarm(void) {
+  uint8_t reported = 0;
+  DeviceAddress alarmAddr;
+
+  // the windows are re-armed between searches, that only changes the alarm
+  // flags at the next conversion
+  resetAlarmSearch();
+  while (alarmSearch(alarmAddr)) {
+    DeviceEntry *entry = findDevice(alarmAddr);
+    if (entry == 0 || !entry->alarmArmed)
+      continue;
+    uint8_t i = entry - deviceTable;
+    if (reportChange(i)) {
+      reported++;
+      armAlarmWindow(i);
+    }
+  }
+
+  for (uint8_t i = 0; i < cachedDeviceCount(); i++) {
+    if (deviceTable[i].alarmArmed)
+      continue;
+    if (reportChange(i))
+      reported++;
+    armAlarmWindow(i);
+  }
+  return reported;
+}
+
+// the devices alarm once the whole degrees of the temperature register are
+// <= TL or >= TH. TH is the first whole degree above reported + deadband and
+// TL the last one below reported - deadband, so every change past the
+// deadband alarms. Deadbands under 16 can't open a window and leave the
+// device read every time
+void DallasTemperature::armAlarmWindow(uint8_t deviceIndex) {
+  DeviceEntry *entry = &deviceTable[deviceIndex];
+  int16_t reported = entry->reportedRaw;
+  entry->alarmArmed = false;
+
+  // MAX31850 has no alarm registers, TH/TL can't be written without knowing
+  // the configuration register
+  if (DEVICE_FAMILY(entry->address) == MAX31850MODEL ||
+      entry->resolution == 0 || reported == DEVICE_DISCONNECTED_RAW ||
+      reported == DEVICE_FAULT_RAW)
+    return;
+
+  int16_t high = (reported + entry->deadband + 1) >> 4;
+  int16_t low = ((reported - entry->deadband + 15) >> 4) - 1;
+  if (high <= low + 1)
+    return;
+
+  SCRATCHPAD(scratchPad);
+  scratchPad[HIGH_ALARM_TEMP] = (uint8_t)constrain(high, -128, 127);
+  scratchPad[LOW_ALARM_TEMP] = (uint8_t)constrain(low, -128, 127);
+  scratchPad[CONFIGURATION] = resolutionToConfiguration(entry->resolution);
+
+  // the window changes every report, keep it out of EEPROM
+  bool autoSave = autoSaveScratchPad;
+  autoSaveScratchPad = false;
+  writeScratchPad(entry->address, scratchPad);
+  autoSaveScratchPad = autoSave;
+  entry->alarmArmed = true;
+}
+
+#endif
+
 // sets the alarm handler
 void DallasTemperature::setAlarmHandler(AlarmHandler *handler) {
   _AlarmHandler = handler;
@@ -692,6 +1957,27 @@ void DallasTemperature::defaultAlarmHandler(uint8_t *deviceAddress) {}
 
 #endif
 
+#if REQUIRESSTATS
+
+// returns a copy of the counters
+DallasTemperatureStats DallasTemperature::getStats(void) { return stats; }
+
+// clears the counters, including those of every device
+void DallasTemperature::resetStats(void) {
+  memset(&stats, 0, sizeof(stats));
+  for (uint8_t i = 0; i < MAXDEVICES; i++)
+    deviceTable[i].crcFailures = 0;
+}
+
+// returns the CRC failures of a cached device
+uint16_t DallasTemperature::getCrcFailuresByIndex(uint8_t deviceIndex) {
+  if (deviceIndex >= cachedDeviceCount())
+    return 0;
+  return deviceTable[deviceIndex].crcFailures;
+}
+
+#endif
+
 // Convert float celsius to fahrenheit
 float DallasTemperature::toFahrenheit(float celsius) {
   return (celsius * 1.8) + 32;
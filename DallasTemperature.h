@@ -21,6 +21,76 @@
   true //!< set to true to include code implementing alarm search functions
 #endif
 
+#ifndef REQUIRESDS2482
+#define REQUIRESDS2482                                                         \
+  false //!< set to true to include the DS2482 I2C bridge transport
+#endif
+
+#ifndef REQUIRESUART
+#define REQUIRESUART                                                           \
+  false //!< set to true to include the UART 1-Wire transport
+#endif
+
+#ifndef REQUIRESCRCTABLE
+#define REQUIRESCRCTABLE                                                       \
+  0 //!< CRC8 implementation: 0 OneWire::crc8, 1 256 byte table, 2 nibble
+    //!< tables (32 bytes)
+#endif
+
+#ifndef REQUIRESMODEL
+#define REQUIRESMODEL                                                          \
+  0 //!< set to a model ID (e.g. DS18B20MODEL) to compile in only the code of
+    //!< that model and ignore devices of other families, 0 supports all
+#endif
+
+#ifndef REQUIRESLOWMEMORY
+#define REQUIRESLOWMEMORY                                                      \
+  false //!< set to true to share one scratchpad buffer per object and pack
+        //!< the device table, trading bus speed for stack and RAM
+#endif
+
+#ifndef REQUIRESCHANGES
+#define REQUIRESCHANGES                                                        \
+  (!REQUIRESLOWMEMORY) //!< set to true to include readChanged(), deadbands
+                       //!< and the change handler, off with REQUIRESLOWMEMORY
+#endif
+
+#ifndef REQUIRESDISCOVERY
+#define REQUIRESDISCOVERY                                                      \
+  (!REQUIRESLOWMEMORY) //!< set to true to include hot-plug discovery, off
+                       //!< with REQUIRESLOWMEMORY
+#endif
+
+#ifndef REQUIRESHEALTH
+#define REQUIRESHEALTH                                                         \
+  (!REQUIRESLOWMEMORY) //!< set to true to count failed reads per device and
+                       //!< skip failing devices, off with REQUIRESLOWMEMORY
+#endif
+
+#ifndef REQUIRESSTATS
+#define REQUIRESSTATS                                                          \
+  false //!< set to true to count bus traffic, errors and time spent on the
+        //!< bus, see getStats()
+#endif
+
+#ifndef SKIPAFTERFAILURES
+#define SKIPAFTERFAILURES                                                      \
+  3 //!< consecutive failed reads after which device table reads skip a
+    //!< device, 0 never skips. Needs REQUIRESHEALTH
+#endif
+
+#ifndef FILTERDEPTH
+#define FILTERDEPTH                                                            \
+  0 //!< raw samples kept per device for setFilter(), 0 leaves the filter
+    //!< out
+#endif
+
+#ifndef MAXDEVICES
+#define MAXDEVICES                                                             \
+  8 //!< number of devices begin() keeps in the device table
+#endif
+
+#include "DallasTemperatureTransport.h"
 #include <OneWire.h>
 #include <inttypes.h>
 
@@ -40,6 +110,7 @@
 #define RECALLSCRATCH 0xB8   //!< Reload from last known
 #define READPOWERSUPPLY 0xB4 //!< Determine if device needs parasite power
 #define ALARMSEARCH 0xEC     //!< Query bus for devices with an alarm condition
+#define MATCHROM 0x55        //!< Address a single device by its ROM code
 
 // Scratchpad locations
 #define TEMP_LSB 0        //!< Temperature LSB byte location
@@ -54,6 +125,18 @@
 #define COUNT_PER_C 7 //!< DS18S20: COUNT_PER_C. DS18B20 & DS1822: store for crc
 #define SCRATCHPAD_CRC 8 //!< Scratchpad CRC
 
+// MAX31850 scratchpad locations
+#define MAX31850_CJ_LSB                                                        \
+  2 //!< MAX31850: cold junction LSB, fault bits in bits 0-2
+#define MAX31850_CJ_MSB 3  //!< MAX31850: cold junction MSB
+#define MAX31850_ADDRESS 4 //!< MAX31850: AD3-AD0 pins in bits 0-3
+#define MAX31850_SLOTS 16  //!< number of AD3-AD0 locations
+
+// MAX31850 fault bits
+#define MAX31850_FAULT_OPEN 0x01      //!< thermocouple open
+#define MAX31850_FAULT_SHORT_GND 0x02 //!< thermocouple shorted to GND
+#define MAX31850_FAULT_SHORT_VDD 0x04 //!< thermocouple shorted to VDD
+
 // Device resolution
 #define TEMP_9_BIT 0x1F  //!<  9 bit resolution
 #define TEMP_10_BIT 0x3F //!< 10 bit resolution
@@ -62,24 +145,186 @@
 
 // Error Codes
 #define DEVICE_DISCONNECTED -127 //!< Device disconnected error code
+#define DEVICE_DISCONNECTED_RAW                                                \
+  -32767 //!< Device disconnected error code for raw temperatures
+#define DEVICE_FAULT_RAW                                                       \
+  -32766 //!< Sensor fault (e.g. MAX31850 open thermocouple) for raw
+         //!< temperatures
+#define DEVICE_DISCONNECTED_MILLIC                                             \
+  -2147483647L //!< Device disconnected error code for getTempMilliC()
+#define DEVICE_FAULT_MILLIC                                                    \
+  -2147483646L //!< Sensor fault error code for getTempMilliC()
 
 typedef uint8_t DeviceAddress[8]; //!< Device address
 
+/*!
+ * @brief everything a MAX31850 scratchpad holds
+ */
+typedef struct {
+  int16_t thermocouple; //!< 1/16 degrees C, DEVICE_FAULT_RAW on a fault
+  int16_t coldJunction; //!< 1/16 degrees C
+  uint8_t faults;       //!< MAX31850_FAULT_ bits, 0 if the thermocouple is ok
+  uint8_t location;     //!< state of the AD3-AD0 pins, 0-15
+} Max31850Reading;
+
+#if REQUIRESSTATS
+/*!
+ * @brief bus and error counters kept with REQUIRESSTATS
+ */
+typedef struct {
+  uint32_t resets;               //!< reset pulses sent outside ROM searches
+  uint32_t presenceFailures;     //!< resets no device answered
+  uint32_t crcFailures;          //!< scratchpads read with a bad CRC
+  uint32_t scratchPadReads;      //!< scratchpad reads, full or partial
+  uint32_t conversions;          //!< STARTCONVO commands sent
+  uint32_t searches;             //!< ROM and alarm search passes
+  uint32_t conversionWaitMillis; //!< milliseconds blocked for conversions
+  uint32_t busMillis;            //!< milliseconds in scratchpad I/O, searches
+  uint16_t conversionWaitMicros; //!< 0-999 microseconds on top of the millis
+  uint16_t busMicros;            //!< 0-999 microseconds on top of busMillis
+} DallasTemperatureStats;
+#endif
+
 /*!
  * @brief DallasTemperature class
  */
 class DallasTemperature {
 public:
+  /*!
+   * @brief states of the non-blocking conversion engine, see poll()
+   */
+  enum ConversionState {
+    CONVERSION_IDLE,       //!< no conversion has been started
+    CONVERSION_CONVERTING, //!< devices are converting
+    CONVERSION_READY,      //!< conversion complete, nothing read yet
+    CONVERSION_READING,    //!< reading one device per call to poll()
+    CONVERSION_DONE        //!< every device in the device table has been read
+  };
+
+#if FILTERDEPTH
+  /*!
+   * @brief filters applied to the raw samples of each device, see setFilter()
+   */
+  enum FilterType {
+    FILTER_NONE,    //!< the last sample
+    FILTER_AVERAGE, //!< average of the last FILTERDEPTH samples
+    FILTER_EMA,     //!< exponential moving average over FILTERDEPTH samples
+    FILTER_MEDIAN3  //!< median of the last 3 samples
+  };
+#endif
+
   /*!
    * @brief DallasTemp constructor
    */
   DallasTemperature(OneWire *);
 
+  /*!
+   * @brief DallasTemp constructor for a bus driven by another transport, such
+   * as DS2482Transport or UARTTransport
+   */
+  DallasTemperature(DallasTemperatureTransport *);
+
   /*!
    * @brief initalise the bus
    */
   void begin(void);
 
+  /*!
+   * @brief Device table writer, stores byte offset of a saved device table
+   */
+  typedef void DeviceTableWriter(uint16_t, uint8_t);
+
+  /*!
+   * @brief Device table reader, returns byte offset of a saved device table
+   */
+  typedef uint8_t DeviceTableReader(uint16_t);
+
+  /*!
+   * @brief returns the number of bytes saveDeviceTable() writes
+   * @return Size of the saved table in bytes
+   */
+  uint16_t getDeviceTableSize(void);
+
+  /*!
+   * @brief saves the device table built by begin(), e.g. to EEPROM, so
+   * beginFast() can skip the search after a reset
+   * @param writer Called once for every byte
+   */
+  void saveDeviceTable(DeviceTableWriter *);
+
+  /*!
+   * @brief restores a device table saved by saveDeviceTable()
+   * @param reader Called once for every byte
+   * @return Returns false, leaving no devices, if the saved table is invalid
+   */
+  bool loadDeviceTable(DeviceTableReader *);
+
+  /*!
+   * @brief initialises the bus from a saved device table without a search.
+   * Every restored device gets a CRC checked scratchpad read the first time
+   * it is read; if it doesn't answer or its resolution changed, needsBegin()
+   * returns true
+   * @param reader Called once for every byte of the saved table
+   * @return Returns true if the saved table was used, false if it was invalid
+   * and begin() ran instead
+   */
+  bool beginFast(DeviceTableReader *);
+
+  /*!
+   * @brief returns true once a device restored by beginFast() didn't answer
+   * as stored. The library doesn't search the bus by itself, since it may be
+   * polled from an interrupt handler; call begin() from normal code to build
+   * the device table again
+   * @return Returns true until begin() runs
+   */
+  bool needsBegin(void);
+
+#if REQUIRESDISCOVERY
+
+  /*!
+   * @brief Discovery handler, called with the address of a device that was
+   * added to or removed from the device table
+   */
+  typedef void DiscoveryHandler(uint8_t *);
+
+  /*!
+   * @brief sets the handlers discoveryStep() reports changes to
+   * @param added Called after a new device was added, 0 for none
+   * @param removed Called after a device was removed, 0 for none
+   */
+  void setDiscoveryHandlers(DiscoveryHandler *, DiscoveryHandler *);
+
+  /*!
+   * @brief lets poll() run a discoveryStep() whenever it finds the bus idle,
+   * including once right after reading the last device of a conversion
+   * @param flag What value to set the discovery flag to
+   */
+  void setDiscovery(bool);
+
+  /*!
+   * @brief gets the value of the discovery flag
+   * @return Returns the value of the discovery flag
+   */
+  bool getDiscovery(void);
+
+  /*!
+   * @brief runs one search() of an incremental discovery pass over the bus.
+   * Devices not in the device table are added at the end, devices missing in
+   * two complete passes in a row are removed and later devices move up one
+   * index. Known devices are never read again, so sampling continues. Only
+   * call it while no conversion is being polled. New devices that don't fit
+   * the full table are neither added nor reported to the added handler,
+   * getUntrackedDeviceCount() counts them once the pass ends. When devices
+   * are removed from a full table, the next pass adds untracked devices in
+   * their place and counts the rest again. begin() and
+   * getAddress() for an index beyond the table search the bus themselves and
+   * start the pass over
+   * @return Returns false when a pass has just finished
+   */
+  bool discoveryStep(void);
+
+#endif
+
   /*!
    * @brief returns the number of devices found on the bus
    * @return Returns the number of devices found on the bus
@@ -87,7 +332,18 @@ public:
   uint8_t getDeviceCount(void);
 
   /*!
-   * @brief Checks if a conversion is complete on the wire
+   * @brief returns the number of devices found on the bus that didn't fit the
+   * device table, counted by begin() and each complete discovery pass. They
+   * are included in getDeviceCount() but not read by the bulk reads
+   * @return Returns the number of untracked devices
+   */
+  uint8_t getUntrackedDeviceCount(void);
+
+  /*!
+   * @brief Checks if a conversion is complete on the wire by issuing a read
+   * time slot. Externally powered devices hold the bus low until they have
+   * finished converting, so this is only meaningful right after STARTCONVO
+   * and without parasite power
    * @return Returns whether the conversion is complete
    */
   bool isConversionComplete(void);
@@ -100,7 +356,8 @@ public:
   bool validAddress(uint8_t *);
 
   /*!
-   * @brief finds an address at a given index on the bus
+   * @brief finds an address at a given index on the bus. Devices found by
+   * begin() are looked up in the device table without touching the bus
    * @param deviceAddress Device address to search for
    * @param index Where on the index to search
    * @return Returns true if the device was found
@@ -128,8 +385,11 @@ public:
    * @brief read device's scratchpad
    * @param deviceAddress Address to read the scratchpad of
    * @param scratchPad Scratch pad to read from
+   * @param length Number of bytes to read from the start of the scratchpad,
+   * shorter reads are cut off with a reset and can't be CRC checked
+   * @return Returns false if no device answered the reset pulse
    */
-  void readScratchPad(uint8_t *, uint8_t *);
+  bool readScratchPad(uint8_t *, uint8_t *, uint8_t length = 9);
 
   /*!
    * @brief write device's scratchpad
@@ -140,10 +400,11 @@ public:
 
   /*!
    * @brief read device's power requirements
-   * @param deviceAddress Address of the device to read from
-   * @return Returns True if the device has power requirements
+   * @param deviceAddress Address of the device to read from, 0 asks every
+   * device on the bus at once
+   * @return Returns True if the device (or any device) has power requirements
    */
-  bool readPowerSupply(uint8_t *);
+  bool readPowerSupply(uint8_t *deviceAddress = 0);
 
   /*!
    * @brief gets global resolution
@@ -152,7 +413,10 @@ public:
   uint8_t getResolution();
 
   /*!
-   * @brief set global resolution to 9, 10, 11, or 12 bits
+   * @brief set global resolution to 9, 10, 11, or 12 bits. When every device
+   * is a DS18B20/DS1822 (or MAX31850, which has a fixed resolution) sharing
+   * the same alarm temperatures, the new configuration is broadcast to all
+   * devices in one transaction
    * @param newResolution Resolution to set to
    */
   void setResolution(uint8_t);
@@ -194,6 +458,44 @@ public:
    */
   bool getCheckForConversion(void);
 
+  /*!
+   * @brief sets the autoSaveScratchPad flag. When cleared, scratchpad writes
+   * (resolution and alarm changes) are not copied to EEPROM: they are faster,
+   * don't wear the EEPROM and are lost on power down
+   * @param flag What value to set the autoSaveScratchPad flag to
+   */
+  void setAutoSaveScratchPad(bool);
+  /*!
+   * @brief gets the value of the autoSaveScratchPad flag
+   * @return Returns the value of the autoSaveScratchPad flag
+   */
+  bool getAutoSaveScratchPad(void);
+
+  /*!
+   * @brief sets the partialRead flag. When set, temperature reads only clock
+   * the scratchpad bytes holding the temperature and skip the CRC check, a
+   * missing device is then only detected from the reset presence pulse
+   * @param flag What value to set the partialRead flag to
+   */
+  void setPartialRead(bool);
+  /*!
+   * @brief gets the value of the partialRead flag
+   * @return Returns the value of the partialRead flag
+   */
+  bool getPartialRead(void);
+
+  /*!
+   * @brief sets how often a scratchpad read that fails its CRC is repeated
+   * before the device is reported disconnected
+   * @param retries Number of extra reads, 0 to fail on the first bad CRC
+   */
+  void setRetries(uint8_t retries);
+  /*!
+   * @brief gets the number of extra reads after a bad CRC
+   * @return Returns the number of retries
+   */
+  uint8_t getRetries(void);
+
   /*!
    * @brief sends command for all devices on the bus to perform a temperature
    * conversion
@@ -228,6 +530,52 @@ public:
    */
   float getTempC(uint8_t *);
 
+  /*!
+   * @brief returns temperature in 1/16 degrees C without any float math. The
+   * error codes are outside the range of every supported device
+   * @param deviceAddress Address of the device to get the temperature from
+   * @return Returns DEVICE_DISCONNECTED_RAW if device is disconnected,
+   * DEVICE_FAULT_RAW on a sensor fault. Otherwise returns the temperature
+   */
+  int16_t getTempRaw(uint8_t *);
+
+  /*!
+   * @brief returns temperature in 1/1000 degrees C without any float math
+   * @param deviceAddress Address of the device to get the temperature from
+   * @return Returns DEVICE_DISCONNECTED_MILLIC if device is disconnected,
+   * DEVICE_FAULT_MILLIC on a sensor fault. Otherwise returns the temperature
+   */
+  int32_t getTempMilliC(uint8_t *);
+
+  /*!
+   * @brief returns temperature in 1/100 degrees C without any float math.
+   * Temperatures above 327.67C saturate
+   * @param deviceAddress Address of the device to get the temperature from
+   * @return Returns DEVICE_DISCONNECTED_RAW if device is disconnected,
+   * DEVICE_FAULT_RAW on a sensor fault. Otherwise returns the temperature
+   */
+  int16_t getTempCentiC(uint8_t *);
+
+  /*!
+   * @brief decodes thermocouple and cold junction temperature, faults and
+   * location of a MAX31850 from a single CRC checked scratchpad read
+   * @param deviceAddress Address of a MAX31850
+   * @param reading Filled with the decoded scratchpad
+   * @return Returns false if the device isn't a MAX31850 or couldn't be read
+   */
+  bool readMAX31850(uint8_t *, Max31850Reading *);
+
+  /*!
+   * @brief reads every cached MAX31850 with readMAX31850()
+   * @param readings Filled with one entry per cached MAX31850, in device
+   * table order, skipping other families. A device that couldn't be read
+   * gets DEVICE_DISCONNECTED_RAW temperatures and the location begin() found
+   * it at, 0xFF if it had none
+   * @param maxReadings Size of readings
+   * @return Returns the number of entries filled
+   */
+  uint8_t readAllMAX31850(Max31850Reading *, uint8_t);
+
   /*!
    * @brief returns temperature in degrees F
    * @param deviceAddress Address of the device to get the temperature from
@@ -252,6 +600,66 @@ public:
    */
   float getTempFByIndex(uint8_t);
 
+  /*!
+   * @brief reads the temperature of every device in the device table, in
+   * index order, with one scratchpad read per device
+   * @param temps Array to fill, temps[i] receives the temperature of device i
+   * in degrees C, DEVICE_DISCONNECTED if it could not be read or NAN on a
+   * sensor fault
+   * @param maxTemps Size of the temps array
+   * @return Returns the number of temperatures read successfully
+   */
+  uint8_t readAllTempsC(float *, uint8_t);
+
+  /*!
+   * @brief reads the raw temperature of every device in the device table, in
+   * index order, with one scratchpad read per device
+   * @param temps Array to fill, temps[i] receives the temperature of device i
+   * in 1/16 degrees C, DEVICE_DISCONNECTED_RAW if it could not be read or
+   * DEVICE_FAULT_RAW on a sensor fault
+   * @param maxTemps Size of the temps array
+   * @return Returns the number of temperatures read successfully
+   */
+  uint8_t readAllTempsRaw(int16_t *, uint8_t);
+
+  /*!
+   * @brief finds the MAX31850 whose AD3-AD0 pins match a slot. The slot map
+   * is built by begin(), if several devices share a slot the first one found
+   * keeps it
+   * @param deviceAddress Filled with the address of the device
+   * @param slot Location 0-15
+   * @return Returns false if no cached MAX31850 has that location
+   */
+  bool getAddressBySlot(uint8_t *, uint8_t);
+
+  /*!
+   * @brief reads the MAX31850 at a slot
+   * @param slot Location 0-15
+   * @return Returns the thermocouple temperature in degrees C,
+   * DEVICE_DISCONNECTED if the slot is empty or the device could not be read,
+   * NAN on a fault
+   */
+  float getTempCBySlot(uint8_t);
+
+  /*!
+   * @brief reads the MAX31850 at a slot
+   * @param slot Location 0-15
+   * @return Returns the thermocouple temperature in 1/16 degrees C,
+   * DEVICE_DISCONNECTED_RAW if the slot is empty or the device could not be
+   * read, DEVICE_FAULT_RAW on a fault
+   */
+  int16_t getTempRawBySlot(uint8_t);
+
+  /*!
+   * @brief reads every occupied slot
+   * @param temps Array to fill, temps[slot] receives the temperature of the
+   * MAX31850 at that location in degrees C, DEVICE_DISCONNECTED for empty
+   * slots and devices that could not be read, NAN on a fault
+   * @param maxTemps Size of the temps array, MAX31850_SLOTS covers all slots
+   * @return Returns the number of temperatures read successfully
+   */
+  uint8_t readAllTempsCBySlot(float *, uint8_t);
+
   /*!
    * @brief returns true if the bus requires parasite power
    * @return returns true if the bus requires parasite power
@@ -260,12 +668,162 @@ public:
 
   /*!
    * @brief Checks if the clock has been raised indicating the conversion is
-   * complete
-   * @param deviceAddress Address of the device to check
+   * complete, same as isConversionComplete(). Completion is signalled on the
+   * bus right after STARTCONVO, not per device
+   * @param deviceAddress Address of the device to check (unused)
    * @return Returns True if conversion is available
    */
   bool isConversionAvailable(uint8_t *);
 
+  /*!
+   * @brief returns the worst case conversion time from the datasheet
+   * @param bitResolution Resolution of the conversion, 9-12
+   * @return Returns the conversion time in milliseconds
+   */
+  uint16_t millisToWaitForConversion(uint8_t);
+
+  /*!
+   * @brief sends command for all devices on the bus to perform a temperature
+   * conversion and returns immediately. Call poll() until it returns
+   * CONVERSION_DONE to collect the results
+   */
+  void startConversion(void);
+
+  /*!
+   * @brief marks the conversion started by startConversion() as complete,
+   * for callers that waited for it themselves, such as
+   * DallasTemperatureGroup. poll() goes on with reading the devices
+   */
+  void finishConversion(void);
+
+  /*!
+   * @brief advances the non-blocking conversion started by startConversion(),
+   * call it from loop(). Completion is detected from the bus on externally
+   * powered buses and from the worst case conversion time under parasite
+   * power. Once complete, every call reads one device into the device table
+   * @return Returns the state of the conversion
+   */
+  ConversionState poll(void);
+
+  /*!
+   * @brief returns the last temperature read by poll() or a bulk read
+   * @param deviceIndex Index of the device
+   * @return Returns the temperature in 1/16 degrees C, DEVICE_DISCONNECTED_RAW
+   * if the device could not be read or DEVICE_FAULT_RAW on a sensor fault
+   */
+  int16_t getLastTempRawByIndex(uint8_t);
+
+  /*!
+   * @brief returns the last temperature read by poll() or a bulk read
+   * @param deviceIndex Index of the device
+   * @return Returns the temperature in degrees C, DEVICE_DISCONNECTED if the
+   * device could not be read or NAN on a sensor fault
+   */
+  float getLastTempCByIndex(uint8_t);
+
+#if FILTERDEPTH
+
+  /*!
+   * @brief sets the filter of readAllTempsC(), readAllTempsRaw() and
+   * getFilteredTempCByIndex(). Every read of the device table keeps the last
+   * FILTERDEPTH raw samples of each device, so averaging several 9-bit
+   * conversions gives a finer reading sooner than one 12-bit conversion
+   * @param type Filter to apply, FILTER_NONE returns the last sample
+   */
+  void setFilter(FilterType type);
+
+  /*!
+   * @brief gets the filter of the bulk reads
+   * @return Returns the filter type
+   */
+  FilterType getFilter(void);
+
+  /*!
+   * @brief returns the filtered temperature of a cached device without
+   * reading it, for use with poll() and pollScheduler()
+   * @param deviceIndex Index of the device
+   * @return Returns the temperature in degrees C, DEVICE_DISCONNECTED if the
+   * last read failed or NAN on a sensor fault
+   */
+  float getFilteredTempCByIndex(uint8_t deviceIndex);
+
+#endif
+
+  /*!
+   * @brief checks whether a device has been read since the last call
+   * @param deviceIndex Index of the device
+   * @return Returns true once for every new reading of the device
+   */
+  bool hasNewReading(uint8_t);
+
+  /*!
+   * @brief runs the per-resolution conversion scheduler, call it from loop()
+   * instead of poll(). Devices are grouped by resolution, each group gets its
+   * own STARTCONVOs and is read as soon as its conversion time has passed, so
+   * 9-bit devices are sampled up to 8 times as often as 12-bit ones on the
+   * same bus. Use hasNewReading() and getLastTempCByIndex() for the results.
+   * Parasite powered buses can't overlap conversions and fall back to
+   * bus-wide conversions
+   * @return Returns the number of devices read by this call
+   */
+  uint8_t pollScheduler(void);
+
+#if REQUIRESHEALTH
+  /*!
+   * @brief returns the health of a cached device. After SKIPAFTERFAILURES
+   * failed reads in a row readAllTempsC(), poll() and the other device table
+   * reads skip the device, reporting it disconnected without bus traffic,
+   * and probe it again after 1, 2, 4 ... 32 skipped reads until it answers
+   * @param deviceIndex Index of the device
+   * @return Returns the number of failed reads in a row, 0 for a healthy
+   * device or an invalid index
+   */
+  uint8_t getFailuresByIndex(uint8_t deviceIndex);
+
+#endif
+
+#if REQUIRESCHANGES
+
+  /*!
+   * @brief Change handler, called with the address and the new raw
+   * temperature of a device
+   */
+  typedef void ChangeHandler(uint8_t *, int16_t);
+
+  /*!
+   * @brief sets the handler readChanged() reports to
+   * @param handler Change handler, 0 for none
+   */
+  void setChangeHandler(ChangeHandler *);
+
+  /*!
+   * @brief sets how far a device's reading has to move before readChanged()
+   * reports it again
+   * @param deviceIndex Index of the device
+   * @param deadband Deadband in 1/16 degrees C, 0 reports every change
+   * @return Returns false if the device isn't in the device table
+   */
+  bool setDeadband(uint8_t, uint8_t);
+
+  /*!
+   * @brief returns the deadband of a device
+   * @param deviceIndex Index of the device
+   * @return Deadband in 1/16 degrees C
+   */
+  uint8_t getDeadband(uint8_t);
+
+  /*!
+   * @brief reads every cached device and calls the change handler for each
+   * one whose raw temperature moved more than its deadband since it was last
+   * reported. A device also gets reported once when it disconnects or
+   * faults, and when it delivers its first reading after that. Start a
+   * conversion first, as for readAllTempsRaw()
+   * @return Returns the number of devices reported
+   */
+  uint8_t readChanged(void);
+
+#endif
+
 #if REQUIRESALARMS
 
   typedef void AlarmHandler(uint8_t *);
@@ -292,6 +850,10 @@ public:
   // search the wire for devices with active alarms
   bool alarmSearch(uint8_t *);
 
+  // fills alarms with the addresses of up to maxAlarms devices with active
+  // alarms, returns the number found
+  uint8_t alarmSearchAll(DeviceAddress *alarms, uint8_t maxAlarms);
+
   // returns true if ia specific device has an alarm
   bool hasAlarm(uint8_t *);
 
@@ -301,6 +863,17 @@ public:
   // runs the alarm handler for all devices returned by alarmSearch()
   void processAlarms(void);
 
+#if REQUIRESCHANGES
+  // like readChanged(), but only reads the devices whose alarm window was
+  // left. The TH/TL scratchpad bytes of every DS18B20, DS1822 and DS18S20
+  // are set to a window around its last reported value (EEPROM isn't
+  // written), so after a conversion one alarm search finds the devices that
+  // moved. Disconnected devices don't show up in the search, call
+  // readChanged() now and then to catch them, it also re-arms all windows
+  // returns the number of devices reported
+  uint8_t readChangedByAlarm(void);
+#endif
+
   // sets the alarm handler
   void setAlarmHandler(AlarmHandler *);
 
@@ -323,6 +896,46 @@ public:
    */
   static float toCelsius(const float);
 
+  /*!
+   * @brief converts a raw temperature, including its error codes, to degrees C
+   * @param raw Raw temperature in 1/16 degrees C
+   * @return Returns the degrees in celsius, DEVICE_DISCONNECTED or NAN for a
+   * fault
+   */
+  static float rawToCelsius(int16_t);
+
+  /*!
+   * @brief computes the Dallas CRC8 of a buffer with the implementation
+   * selected by REQUIRESCRCTABLE
+   * @param data Buffer
+   * @param length Number of bytes
+   * @return Returns the CRC8, 0 for a buffer that ends in its own CRC
+   */
+  static uint8_t crc8(const uint8_t *data, uint8_t length);
+
+#if REQUIRESSTATS
+
+  /*!
+   * @brief returns the bus and error counters, counting since the object was
+   * created or resetStats() was called
+   * @return Returns a copy of the counters
+   */
+  DallasTemperatureStats getStats(void);
+
+  /*!
+   * @brief clears the counters, including the CRC failures of every device
+   */
+  void resetStats(void);
+
+  /*!
+   * @brief returns the CRC failures of a device in the device table
+   * @param deviceIndex Index of the device
+   * @return Returns the number of bad scratchpads read, 0 for an invalid index
+   */
+  uint16_t getCrcFailuresByIndex(uint8_t deviceIndex);
+
+#endif
+
 #if REQUIRESNEW
 
   // initalize memory area
@@ -336,6 +949,12 @@ public:
 private:
   typedef uint8_t ScratchPad[9];
 
+#if REQUIRESLOWMEMORY
+  // the scratchpad buffer of every call, no call holds it while calling
+  // another one that reads into it
+  ScratchPad sharedScratchPad;
+#endif
+
   // parasite power on or off
   bool parasite;
 
@@ -349,16 +968,200 @@ private:
   // used to requestTemperature to dynamically check if a conversion is complete
   bool checkForConversion;
 
+  // used to read temperatures without the full scratchpad and CRC
+  bool partialRead;
+
+  // extra reads of a scratchpad that failed its CRC
+  uint8_t retries;
+
+  // used to copy scratchpad writes to EEPROM
+  bool autoSaveScratchPad;
+
   // count of devices on the bus
   uint8_t devices;
 
+  // per-device state cached by begin()
+  typedef struct {
+    DeviceAddress address; // ROM code, address[0] is the family code
+#if REQUIRESLOWMEMORY
+    uint8_t resolution : 4; // 9-12, 0 if it could not be read
+    uint8_t newReading : 1; // lastRaw hasn't been seen by hasNewReading()
+    uint8_t verified : 1;   // answered since it was restored by beginFast()
+#if REQUIRESCHANGES
+    uint8_t alarmArmed : 1; // TH/TL hold the window of readChangedByAlarm()
+#endif
+#if REQUIRESDISCOVERY
+    uint8_t seen : 1;    // found by the current discovery pass
+    uint8_t missing : 1; // not found by the last complete discovery pass
+#endif
+#else
+    uint8_t resolution; // 9-12, 0 if it could not be read
+    bool newReading;    // lastRaw hasn't been seen by hasNewReading()
+    bool verified;      // answered since it was restored by beginFast()
+#if REQUIRESCHANGES
+    bool alarmArmed; // TH/TL hold the window of readChangedByAlarm()
+#endif
+#if REQUIRESDISCOVERY
+    bool seen;    // found by the current discovery pass
+    bool missing; // not found by the last complete discovery pass
+#endif
+#endif
+    uint8_t highAlarm; // TH register, valid if resolution is known
+    uint8_t lowAlarm;  // TL register, valid if resolution is known
+    int16_t lastRaw;   // last temperature read, 1/16 degrees C
+#if REQUIRESCHANGES
+    uint8_t deadband;    // change in 1/16 degrees C readChanged() ignores
+    int16_t reportedRaw; // last temperature given to the change handler
+#endif
+#if REQUIRESHEALTH
+    uint8_t failures; // failed reads in a row, saturating at 255
+    uint8_t skip;     // device table reads left to skip before a probe
+#endif
+#if FILTERDEPTH
+    int16_t samples[FILTERDEPTH]; // ring of the last raw samples
+    uint8_t sampleCount;          // samples held, up to FILTERDEPTH
+    uint8_t sampleNext;           // ring index the next sample goes to
+    int32_t average;              // exponential average, 1/256 degrees C
+#endif
+#if REQUIRESSTATS
+    uint16_t crcFailures; // scratchpads read with a bad CRC
+#endif
+  } DeviceEntry;
+
+  // the first MAXDEVICES devices found on the bus, in search order
+  DeviceEntry deviceTable[MAXDEVICES];
+
+  // device table index of the MAX31850 at each AD3-AD0 location, 0xFF if
+  // the slot is empty
+  uint8_t slotTable[MAX31850_SLOTS];
+
+  // devices restored by beginFast() that haven't been read yet
+  uint8_t unverifiedDevices;
+
+  // a restored device didn't answer as stored, see needsBegin()
+  bool tableMismatch;
+
+  // counts a device found by a search and adds it to the device table
+  void cacheDevice(uint8_t *);
+
+#if REQUIRESDISCOVERY
+  // drops a device from the device table
+  void removeDevice(uint8_t);
+
+  // used by poll() to run discovery steps
+  bool discovery;
+
+  // a discovery pass is in progress
+  bool discoveryActive;
+
+  // devices found by the current pass that didn't fit the device table
+  uint8_t discoveryUntracked;
+
+  // the discovery handler function pointers, 0 if none is set
+  DiscoveryHandler *_AddedHandler;
+  DiscoveryHandler *_RemovedHandler;
+#endif
+
+  // returns the device table entry for an address, 0 if it is not cached
+  DeviceEntry *findDevice(const uint8_t *);
+
+  // number of devices held in the device table
+  uint8_t cachedDeviceCount(void);
+
+  // state of the non-blocking conversion engine
+  ConversionState conversionState;
+
+  // millis() when the last conversion was started
+  unsigned long conversionStart;
+
+  // next device to read while CONVERSION_READING
+  uint8_t conversionIndex;
+
+  // millis() when each resolution group (9-12 bits) of the scheduler started
+  unsigned long groupStart[4];
+
+  // bit n set while the scheduler's (9 + n)-bit group is converting
+  uint8_t groupsConverting;
+
+  // resolution a cached device converts at, 12 if it is unknown
+  uint8_t conversionResolution(uint8_t);
+
+  // reads a cached device and stores its raw temperature in the device table
+  int16_t readDeviceTemperature(uint8_t);
+
+#if FILTERDEPTH
+  // filter of the bulk reads
+  FilterType filter;
+
+  // adds a valid raw temperature to the ring of a device
+  void addSample(DeviceEntry *, int16_t);
+
+  // returns the filtered temperature of a device in 1/256 degrees C
+  int32_t filteredValue(const DeviceEntry *);
+
+  // returns the filtered temperature of a device in 1/16 degrees C
+  int16_t filteredRaw(uint8_t);
+#endif
+
+  // decodes a MAX31850 scratchpad
+  static void decodeMAX31850(const uint8_t *, Max31850Reading *);
+
+  // reads the scratchpad bytes needed for a temperature, honouring partialRead
+  bool readTempScratchPad(uint8_t *, uint8_t *);
+
+  // returns the configuration register value for a resolution, 9-12
+  static uint8_t resolutionToConfiguration(uint8_t);
+
+  // decodes the resolution from a scratchpad, 0 if it isn't recognised
+  static uint8_t resolutionFromScratchPad(uint8_t *, uint8_t *);
+
+  // adds one byte to a CRC8 with the REQUIRESCRCTABLE implementation
+  static uint8_t crc8Update(uint8_t, uint8_t);
+
+  // sends a reset pulse, returns 1 if a device answered
+  uint8_t resetBus(void);
+
+  // finds the next device of the ROM search
+  uint8_t searchBus(uint8_t *);
+
+  // sends a reset followed by MATCH ROM, or SKIP ROM for a 0 address
+  void selectDevice(uint8_t *);
+
+  // copies the scratchpad of a device, or of all devices, to EEPROM
+  void copyScratchPad(uint8_t *);
+
+  // returns the device whose TH/TL a resolution broadcast can reuse, or 0
+  DeviceEntry *resolutionBroadcastSource(void);
+
   // Take a pointer to one wire instance
-  OneWire *_wire;
+  DallasTemperatureTransport *_wire;
+
+  // transport wrapping the OneWire instance given to the constructor
+  OneWireTransport _oneWireTransport;
+
+  // sets the state shared by the constructors
+  void init(void);
 
   // reads scratchpad and returns the temperature in degrees C
   float calculateTemperature(uint8_t *, uint8_t *);
 
-  void blockTillConversionComplete(uint8_t *, uint8_t *);
+  // reads scratchpad and returns the temperature in 1/16 degrees C
+  int16_t calculateRawTemperature(uint8_t *, uint8_t *);
+
+  void blockTillConversionComplete(uint8_t);
+
+#if REQUIRESCHANGES
+  // the change handler function pointer, 0 if none is set
+  ChangeHandler *_ChangeHandler;
+
+  // reads a cached device and reports it if it moved past its deadband
+  bool reportChange(uint8_t);
+#endif
+
+#if REQUIRESSTATS
+  // counters returned by getStats()
+  DallasTemperatureStats stats;
+#endif
 
 #if REQUIRESALARMS
 
@@ -370,6 +1173,11 @@ private:
   // the alarm handler function pointer
   AlarmHandler *_AlarmHandler;
 
+#if REQUIRESCHANGES
+  // sets TH/TL of a cached device to the window around its reported value
+  void armAlarmWindow(uint8_t);
+#endif
+
 #endif
 };
 #endif
@@ -0,0 +1,119 @@
+/*!
+ * @file DallasTemperatureGroup.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperatureGroup.h"
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+DallasTemperatureGroup::DallasTemperatureGroup() { busCount = 0; }
+
+bool DallasTemperatureGroup::addBus(DallasTemperature *bus) {
+  if (busCount >= MAXBUSES)
+    return false;
+  buses[busCount++] = bus;
+  return true;
+}
+
+void DallasTemperatureGroup::begin(void) {
+  for (uint8_t i = 0; i < busCount; i++)
+    buses[i]->begin();
+}
+
+uint8_t DallasTemperatureGroup::getBusCount(void) { return busCount; }
+
+uint8_t DallasTemperatureGroup::getDeviceCount(void) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < busCount; i++)
+    count += busDeviceCount(buses[i]);
+  return count;
+}
+
+// bulk reads only cover the device table
+uint8_t DallasTemperatureGroup::busDeviceCount(DallasTemperature *bus) {
+  uint8_t count = bus->getDeviceCount();
+  return (count < MAXDEVICES) ? count : MAXDEVICES;
+}
+
+// the buses are independent, so their conversions run at the same time and
+// the sweep takes as long as the slowest bus instead of the sum of all buses
+void DallasTemperatureGroup::requestTemperatures(void) {
+  uint16_t conversionTime = 0;
+  uint8_t pending = 0;
+
+  for (uint8_t i = 0; i < busCount; i++) {
+    buses[i]->startConversion();
+    uint16_t busTime = buses[i]->millisToWaitForConversion(
+        buses[i]->getResolution());
+    if (busTime > conversionTime)
+      conversionTime = busTime;
+    pending |= (1 << i);
+  }
+
+  // externally powered buses report completion through read time slots,
+  // parasite powered ones wait for the worst case time
+  unsigned long start = millis();
+  while (pending && (millis() - start) < conversionTime) {
+    for (uint8_t i = 0; i < busCount; i++) {
+      if ((pending & (1 << i)) && buses[i]->getCheckForConversion() &&
+          !buses[i]->isParasitePowerMode() &&
+          buses[i]->isConversionComplete())
+        pending &= ~(1 << i);
+    }
+  }
+
+  // every bus is done now, as after DallasTemperature::requestTemperatures()
+  for (uint8_t i = 0; i < busCount; i++)
+    buses[i]->finishConversion();
+}
+
+uint8_t DallasTemperatureGroup::readAllTempsC(float *temps, uint8_t maxTemps) {
+  uint8_t offset = 0;
+  uint8_t valid = 0;
+
+  for (uint8_t i = 0; i < busCount && offset < maxTemps; i++) {
+    valid += buses[i]->readAllTempsC(temps + offset, maxTemps - offset);
+    offset += busDeviceCount(buses[i]);
+  }
+  return valid;
+}
+
+uint8_t DallasTemperatureGroup::readAllTempsRaw(int16_t *temps,
+                                                uint8_t maxTemps) {
+  uint8_t offset = 0;
+  uint8_t valid = 0;
+
+  for (uint8_t i = 0; i < busCount && offset < maxTemps; i++) {
+    valid += buses[i]->readAllTempsRaw(temps + offset, maxTemps - offset);
+    offset += busDeviceCount(buses[i]);
+  }
+  return valid;
+}
+
+bool DallasTemperatureGroup::locateDevice(uint8_t index, uint8_t *busIndex,
+                                          uint8_t *deviceIndex) {
+  for (uint8_t i = 0; i < busCount; i++) {
+    uint8_t count = busDeviceCount(buses[i]);
+    if (index < count) {
+      *busIndex = i;
+      *deviceIndex = index;
+      return true;
+    }
+    index -= count;
+  }
+  return false;
+}
+
+DallasTemperature *DallasTemperatureGroup::getBus(uint8_t busIndex) {
+  return (busIndex < busCount) ? buses[busIndex] : 0;
+}
@@ -0,0 +1,103 @@
+/*!
+ * @file DallasTemperatureGroup.h
+ */
+#ifndef DallasTemperatureGroup_h
+#define DallasTemperatureGroup_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#ifndef MAXBUSES
+#define MAXBUSES                                                               \
+  6 //!< number of DallasTemperature instances a group can hold, at most 8
+#endif
+
+/*!
+ * @brief Runs the conversions of several buses in parallel. Every bus gets its
+ * STARTCONVO back to back, the group waits once for the slowest one and then
+ * reads the buses in the order they were added. Devices are numbered across
+ * the group: the devices of the first bus come first, then the second bus...
+ */
+class DallasTemperatureGroup {
+public:
+  /*!
+   * @brief DallasTemperatureGroup constructor
+   */
+  DallasTemperatureGroup();
+
+  /*!
+   * @brief adds a bus to the group
+   * @param bus DallasTemperature instance of the bus
+   * @return Returns false if the group already holds MAXBUSES buses
+   */
+  bool addBus(DallasTemperature *bus);
+
+  /*!
+   * @brief calls begin() on every bus
+   */
+  void begin(void);
+
+  /*!
+   * @brief returns the number of buses in the group
+   * @return Bus count
+   */
+  uint8_t getBusCount(void);
+
+  /*!
+   * @brief returns the number of cached devices of all buses
+   * @return Device count
+   */
+  uint8_t getDeviceCount(void);
+
+  /*!
+   * @brief starts a conversion on every bus and waits until the slowest bus
+   * is done
+   */
+  void requestTemperatures(void);
+
+  /*!
+   * @brief reads every cached device of every bus
+   * @param temps Array the temperatures in degrees C are stored in, group
+   * index order
+   * @param maxTemps Size of temps
+   * @return Returns the number of temperatures read successfully
+   */
+  uint8_t readAllTempsC(float *temps, uint8_t maxTemps);
+
+  /*!
+   * @brief reads every cached device of every bus
+   * @param temps Array the raw temperatures are stored in, group index order
+   * @param maxTemps Size of temps
+   * @return Returns the number of temperatures read successfully
+   */
+  uint8_t readAllTempsRaw(int16_t *temps, uint8_t maxTemps);
+
+  /*!
+   * @brief maps a group device index to its bus
+   * @param index Group device index
+   * @param busIndex Set to the position of the bus in the group
+   * @param deviceIndex Set to the device index on that bus
+   * @return Returns false if index is out of range
+   */
+  bool locateDevice(uint8_t index, uint8_t *busIndex, uint8_t *deviceIndex);
+
+  /*!
+   * @brief returns the bus at a position in the group
+   * @param busIndex Position of the bus
+   * @return Bus, 0 if busIndex is out of range
+   */
+  DallasTemperature *getBus(uint8_t busIndex);
+
+private:
+  DallasTemperature *buses[MAXBUSES];
+  uint8_t busCount;
+
+  // number of devices a bus keeps in its device table
+  static uint8_t busDeviceCount(DallasTemperature *bus);
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*!
+ * @file DallasTemperatureSampler.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperatureSampler.h"
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+#if defined(__AVR__) && REQUIRESSAMPLERTIMER
+#include <avr/interrupt.h>
+#endif
+
+// the indexes wrap at the buffer size
+#define SAMPLERQUEUEMASK (SAMPLERQUEUESIZE - 1)
+
+DallasTemperatureSampler::DallasTemperatureSampler(DallasTemperature *sensors) {
+  _sensors = sensors;
+  head = 0;
+  tail = 0;
+  dropped = 0;
+  busy = false;
+#if defined(__AVR__) && REQUIRESSAMPLERTIMER
+  timerTick = false;
+#endif
+#if defined(ARDUINO_ARCH_ESP32)
+  task = 0;
+#endif
+}
+
+// the conversion timing comes from poll(): read time slots on externally
+// powered buses, the datasheet time of the bus resolution otherwise
+void DallasTemperatureSampler::step(void) {
+  if (busy)
+    return;
+  busy = true;
+
+  DallasTemperature::ConversionState state = _sensors->poll();
+  if (state == DallasTemperature::CONVERSION_READING ||
+      state == DallasTemperature::CONVERSION_DONE) {
+    uint8_t count = _sensors->getDeviceCount();
+    if (count > MAXDEVICES)
+      count = MAXDEVICES;
+    for (uint8_t i = 0; i < count; i++) {
+      if (_sensors->hasNewReading(i))
+        publish(i, _sensors->getLastTempRawByIndex(i));
+    }
+  }
+
+  if (state == DallasTemperature::CONVERSION_IDLE ||
+      state == DallasTemperature::CONVERSION_DONE)
+    _sensors->startConversion();
+
+  busy = false;
+}
+
+// the record is complete before head moves, so the consumer never sees a
+// half written one
+void DallasTemperatureSampler::publish(uint8_t index, int16_t raw) {
+  uint8_t next = (head + 1) & SAMPLERQUEUEMASK;
+  if (next == tail) {
+    dropped++;
+    return;
+  }
+
+  queue[head].index = index;
+  queue[head].raw = raw;
+  queue[head].timestamp = millis();
+  __sync_synchronize();
+  head = next;
+}
+
+uint8_t DallasTemperatureSampler::available(void) {
+  return (head - tail) & SAMPLERQUEUEMASK;
+}
+
+bool DallasTemperatureSampler::read(SampleRecord *record) {
+  uint8_t current = tail;
+  if (current == head)
+    return false;
+
+  __sync_synchronize();
+  *record = queue[current];
+  __sync_synchronize();
+  tail = (current + 1) & SAMPLERQUEUEMASK;
+  return true;
+}
+
+uint16_t DallasTemperatureSampler::getDropped(void) { return dropped; }
+
+#if defined(__AVR__) && REQUIRESSAMPLERTIMER
+
+DallasTemperatureSampler *DallasTemperatureSampler::timerSampler = 0;
+
+// CTC mode, clk/1024 and OCR2A 155 give 100.16Hz at 16MHz
+void DallasTemperatureSampler::beginTimer(void) {
+  timerSampler = this;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  TCCR2A = (1 << WGM21);
+  TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20);
+  OCR2A = (F_CPU / 1024 / 100) - 1;
+  TCNT2 = 0;
+  TIMSK2 |= (1 << OCIE2A);
+  SREG = oldSREG;
+}
+
+void DallasTemperatureSampler::endTimer(void) {
+  TIMSK2 &= ~(1 << OCIE2A);
+  timerSampler = 0;
+}
+
+void DallasTemperatureSampler::service(void) {
+  if (!timerTick)
+    return;
+  timerTick = false;
+  step();
+}
+
+// the handler stays short, a scratchpad read here would block millis() and
+// Serial for about 10ms per device
+ISR(TIMER2_COMPA_vect) {
+  if (DallasTemperatureSampler::timerSampler)
+    DallasTemperatureSampler::timerSampler->timerTick = true;
+}
+
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool DallasTemperatureSampler::beginTask(uint32_t stackSize,
+                                         uint8_t priority) {
+  if (task)
+    return true;
+  return xTaskCreate(taskEntry, "DallasTemp", stackSize, this, priority,
+                     &task) == pdPASS;
+}
+
+void DallasTemperatureSampler::endTask(void) {
+  if (task) {
+    vTaskDelete(task);
+    task = 0;
+  }
+}
+
+// polls every tick, the read time slot poll() does while converting is
+// short enough not to starve other tasks
+void DallasTemperatureSampler::taskEntry(void *sampler) {
+  for (;;) {
+    ((DallasTemperatureSampler *)sampler)->step();
+    vTaskDelay(1);
+  }
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*!
+ * @file DallasTemperatureSampler.h
+ */
+#ifndef DallasTemperatureSampler_h
+#define DallasTemperatureSampler_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#ifndef SAMPLERQUEUESIZE
+#define SAMPLERQUEUESIZE                                                       \
+  16 //!< number of records the sampler buffers, a power of two up to 128
+#endif
+
+// the ring indices are uint8_t and wrap with a mask of the size
+#if SAMPLERQUEUESIZE <= 0 || SAMPLERQUEUESIZE > 128 || (SAMPLERQUEUESIZE & (SAMPLERQUEUESIZE - 1)) != 0
+#error "SAMPLERQUEUESIZE must be a power of two up to 128"
+#endif
+
+#ifndef REQUIRESSAMPLERTIMER
+#define REQUIRESSAMPLERTIMER                                                   \
+  false //!< set to true to pace the sampler with Timer2 on AVR, tone() and
+        //!< other Timer2 users stop working
+#endif
+
+/*!
+ * @brief one temperature published by the sampler
+ */
+typedef struct {
+  uint8_t index;           //!< device table index of the device
+  int16_t raw;             //!< raw temperature, see getTempRaw()
+  unsigned long timestamp; //!< millis() when the device was read
+} SampleRecord;
+
+/*!
+ * @brief Runs the startConversion() -> poll() cycle of a DallasTemperature in
+ * the background and publishes every reading into a ring buffer. The sampler
+ * is the only producer and loop() the only consumer, so neither side needs a
+ * lock. While the sampler runs it owns the bus: loop() must not call any other
+ * DallasTemperature method, including hasNewReading()
+ */
+class DallasTemperatureSampler {
+public:
+  /*!
+   * @brief DallasTemperatureSampler constructor
+   * @param sensors Bus to sample, begin() must have been called
+   */
+  DallasTemperatureSampler(DallasTemperature *sensors);
+
+  /*!
+   * @brief advances the sampling cycle by one poll(), reading at most one
+   * device. Called by the task or service(), or from your own scheduler.
+   * Calls made while a previous one is still running return at once
+   */
+  void step(void);
+
+  /*!
+   * @brief returns the number of records waiting in the buffer
+   * @return Record count
+   */
+  uint8_t available(void);
+
+  /*!
+   * @brief takes the oldest record from the buffer
+   * @param record Filled with the record
+   * @return Returns false if the buffer is empty
+   */
+  bool read(SampleRecord *record);
+
+  /*!
+   * @brief returns the number of readings lost because the buffer was full
+   * @return Dropped record count
+   */
+  uint16_t getDropped(void);
+
+#if defined(__AVR__) && REQUIRESSAMPLERTIMER
+  /*!
+   * @brief starts the Timer2 compare interrupt at about 100Hz. The interrupt
+   * only flags a tick, service() does the bus traffic from loop(): a
+   * scratchpad read takes about 10ms of bit-banged time slots per device,
+   * too long for an interrupt handler
+   */
+  void beginTimer(void);
+
+  /*!
+   * @brief runs step() if the timer ticked since the last call, call it from
+   * loop() after beginTimer(). Missed ticks are merged into one step()
+   */
+  void service(void);
+
+  /*!
+   * @brief stops the Timer2 interrupt
+   */
+  void endTimer(void);
+
+  /*!
+   * @brief sampler paced by the timer, used by the interrupt handler
+   */
+  static DallasTemperatureSampler *timerSampler;
+
+  /*!
+   * @brief set by the interrupt handler, cleared by service()
+   */
+  volatile bool timerTick;
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * @brief runs step() in a FreeRTOS task of its own
+   * @param stackSize Task stack size in bytes
+   * @param priority Task priority
+   * @return Returns false if the task couldn't be created
+   */
+  bool beginTask(uint32_t stackSize = 2048, uint8_t priority = 1);
+
+  /*!
+   * @brief deletes the task started by beginTask()
+   */
+  void endTask(void);
+#endif
+
+private:
+  DallasTemperature *_sensors;
+
+  // ring buffer, head is only written by the producer, tail by the consumer
+  SampleRecord queue[SAMPLERQUEUESIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint16_t dropped;
+
+  // set while step() runs
+  volatile bool busy;
+
+  // adds a record, drops it if the buffer is full
+  void publish(uint8_t index, int16_t raw);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  TaskHandle_t task;
+
+  static void taskEntry(void *);
+#endif
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*!
+ * @file DallasTemperatureTransport.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperatureTransport.h"
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+// ROM commands
+#define SEARCHROM 0xF0 // enumerate the devices on the bus
+#define MATCHROM 0x55  // address a single device
+#define SKIPROM 0xCC   // address every device
+
+DallasTemperatureTransport::DallasTemperatureTransport(void) {
+  DallasTemperatureTransport::reset_search();
+}
+
+// writes a byte one bit at a time, LSB first
+void DallasTemperatureTransport::write(uint8_t v, uint8_t power) {
+  for (uint8_t mask = 0x01; mask; mask <<= 1)
+    write_bit((v & mask) ? 1 : 0);
+}
+
+// reads a byte one bit at a time, LSB first
+uint8_t DallasTemperatureTransport::read(void) {
+  uint8_t v = 0;
+  for (uint8_t mask = 0x01; mask; mask <<= 1) {
+    if (read_bit())
+      v |= mask;
+  }
+  return v;
+}
+
+// writes a block of bytes, keeping the strong pullup on after the last one if
+// power is set
+void DallasTemperatureTransport::write_bytes(const uint8_t *buf, uint16_t count,
+                                             bool power) {
+  for (uint16_t i = 0; i < count; i++)
+    write(buf[i], (i == count - 1) ? power : 0);
+}
+
+// reads a block of bytes
+void DallasTemperatureTransport::read_bytes(uint8_t *buf, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++)
+    buf[i] = read();
+}
+
+// no strong pullup by default
+void DallasTemperatureTransport::depower(void) {}
+
+// sends MATCH ROM followed by the ROM code
+void DallasTemperatureTransport::select(const uint8_t rom[8]) {
+  write(MATCHROM);
+  for (uint8_t i = 0; i < 8; i++)
+    write(rom[i]);
+}
+
+// sends SKIP ROM
+void DallasTemperatureTransport::skip(void) { write(SKIPROM); }
+
+// restarts the ROM search
+void DallasTemperatureTransport::reset_search(void) {
+  searchLastDiscrepancy = 0;
+  searchLastDevice = false;
+  for (uint8_t i = 0; i < 8; i++)
+    searchRom[i] = 0;
+}
+
+// reads a bit and its complement, then writes the direction taken
+uint8_t DallasTemperatureTransport::triplet(uint8_t direction) {
+  uint8_t idBit = read_bit();
+  uint8_t cmpIdBit = read_bit();
+
+  // nobody answered, the search is over
+  if (idBit && cmpIdBit)
+    return 0x03;
+
+  // all remaining devices agree on the bit
+  if (idBit != cmpIdBit)
+    direction = idBit;
+  write_bit(direction);
+  return idBit | (cmpIdBit << 1) | (direction << 2);
+}
+
+// finds the next device using the search algorithm from Maxim application
+// note 187, returns 0 once every device has been found
+uint8_t DallasTemperatureTransport::search(uint8_t *newAddr) {
+  uint8_t idBitNumber = 1;
+  uint8_t lastZero = 0;
+  uint8_t romByteNumber = 0;
+  uint8_t romByteMask = 1;
+  bool found = false;
+
+  if (!searchLastDevice) {
+    if (!reset()) {
+      reset_search();
+      return 0;
+    }
+    write(SEARCHROM);
+
+    do {
+      uint8_t direction;
+      if (idBitNumber < searchLastDiscrepancy)
+        direction = (searchRom[romByteNumber] & romByteMask) ? 1 : 0;
+      else
+        direction = (idBitNumber == searchLastDiscrepancy) ? 1 : 0;
+
+      uint8_t result = triplet(direction);
+      if ((result & 0x03) == 0x03)
+        break;
+      direction = (result >> 2) & 0x01;
+
+      // devices disagreed and we went the 0 way, come back here next time
+      if ((result & 0x03) == 0 && direction == 0)
+        lastZero = idBitNumber;
+
+      if (direction)
+        searchRom[romByteNumber] |= romByteMask;
+      else
+        searchRom[romByteNumber] &= ~romByteMask;
+
+      idBitNumber++;
+      romByteMask <<= 1;
+      if (romByteMask == 0) {
+        romByteNumber++;
+        romByteMask = 1;
+      }
+    } while (romByteNumber < 8);
+
+    if (idBitNumber > 64) {
+      searchLastDiscrepancy = lastZero;
+      if (searchLastDiscrepancy == 0)
+        searchLastDevice = true;
+      found = true;
+    }
+  }
+
+  if (!found || searchRom[0] == 0) {
+    reset_search();
+    return 0;
+  }
+  for (uint8_t i = 0; i < 8; i++)
+    newAddr[i] = searchRom[i];
+  return 1;
+}
+
+OneWireTransport::OneWireTransport(OneWire *oneWire) { _oneWire = oneWire; }
+
+uint8_t OneWireTransport::reset(void) { return _oneWire->reset(); }
+
+void OneWireTransport::write_bit(uint8_t v) { _oneWire->write_bit(v); }
+
+uint8_t OneWireTransport::read_bit(void) { return _oneWire->read_bit(); }
+
+void OneWireTransport::write(uint8_t v, uint8_t power) {
+  _oneWire->write(v, power);
+}
+
+uint8_t OneWireTransport::read(void) { return _oneWire->read(); }
+
+void OneWireTransport::write_bytes(const uint8_t *buf, uint16_t count,
+                                   bool power) {
+  _oneWire->write_bytes(buf, count, power);
+}
+
+void OneWireTransport::read_bytes(uint8_t *buf, uint16_t count) {
+  _oneWire->read_bytes(buf, count);
+}
+
+void OneWireTransport::depower(void) { _oneWire->depower(); }
+
+void OneWireTransport::select(const uint8_t rom[8]) { _oneWire->select(rom); }
+
+void OneWireTransport::skip(void) { _oneWire->skip(); }
+
+void OneWireTransport::reset_search(void) { _oneWire->reset_search(); }
+
+uint8_t OneWireTransport::search(uint8_t *newAddr) {
+  return _oneWire->search(newAddr);
+}
@@ -0,0 +1,144 @@
+/*!
+ * @file DallasTemperatureTransport.h
+ */
+#ifndef DallasTemperatureTransport_h
+#define DallasTemperatureTransport_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include <OneWire.h>
+#include <inttypes.h>
+
+/*!
+ * @brief 1-Wire bus master used by DallasTemperature. Implementations only
+ * need reset and bit I/O, everything else has bit-level defaults that bridges
+ * with hardware support for bytes, blocks or search triplets can override
+ */
+class DallasTemperatureTransport {
+public:
+  DallasTemperatureTransport(void);
+
+  /*!
+   * @brief sends a reset pulse
+   * @return Returns 1 if a device answered with a presence pulse
+   */
+  virtual uint8_t reset(void) = 0;
+
+  /*!
+   * @brief writes a single bit time slot
+   * @param v Bit to write
+   */
+  virtual void write_bit(uint8_t v) = 0;
+
+  /*!
+   * @brief reads a single bit time slot
+   * @return Returns the bit read
+   */
+  virtual uint8_t read_bit(void) = 0;
+
+  /*!
+   * @brief writes a byte, LSB first
+   * @param v Byte to write
+   * @param power Leave the strong pullup on after the byte, see depower()
+   */
+  virtual void write(uint8_t v, uint8_t power = 0);
+
+  /*!
+   * @brief reads a byte, LSB first
+   * @return Returns the byte read
+   */
+  virtual uint8_t read(void);
+
+  /*!
+   * @brief writes a block of bytes
+   * @param buf Bytes to write
+   * @param count Number of bytes to write
+   * @param power Leave the strong pullup on after the last byte
+   */
+  virtual void write_bytes(const uint8_t *buf, uint16_t count,
+                           bool power = 0);
+
+  /*!
+   * @brief reads a block of bytes
+   * @param buf Buffer to fill
+   * @param count Number of bytes to read
+   */
+  virtual void read_bytes(uint8_t *buf, uint16_t count);
+
+  /*!
+   * @brief turns the strong pullup left on by write() off
+   */
+  virtual void depower(void);
+
+  /*!
+   * @brief sends MATCH ROM for a device, call after reset()
+   * @param rom ROM code of the device
+   */
+  virtual void select(const uint8_t rom[8]);
+
+  /*!
+   * @brief sends SKIP ROM to address every device, call after reset()
+   */
+  virtual void skip(void);
+
+  /*!
+   * @brief restarts search() from the first device
+   */
+  virtual void reset_search(void);
+
+  /*!
+   * @brief finds the next device on the bus
+   * @param newAddr Receives the ROM code of the device
+   * @return Returns 1 if a device was found, 0 once all have been found
+   */
+  virtual uint8_t search(uint8_t *newAddr);
+
+protected:
+  /*!
+   * @brief one step of the ROM search: reads a bit and its complement and
+   * writes the direction taken
+   * @param direction Direction to take if devices disagree on the bit
+   * @return Returns the bit in bit 0, the complement in bit 1 and the
+   * direction taken in bit 2
+   */
+  virtual uint8_t triplet(uint8_t direction);
+
+private:
+  // search state, see Maxim application note 187
+  uint8_t searchRom[8];
+  uint8_t searchLastDiscrepancy;
+  bool searchLastDevice;
+};
+
+/*!
+ * @brief transport over the bit-banged OneWire library
+ */
+class OneWireTransport : public DallasTemperatureTransport {
+public:
+  /*!
+   * @brief OneWireTransport constructor
+   * @param oneWire OneWire instance driving the bus
+   */
+  OneWireTransport(OneWire *oneWire = 0);
+
+  uint8_t reset(void);
+  void write_bit(uint8_t v);
+  uint8_t read_bit(void);
+  void write(uint8_t v, uint8_t power = 0);
+  uint8_t read(void);
+  void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
+  void read_bytes(uint8_t *buf, uint16_t count);
+  void depower(void);
+  void select(const uint8_t rom[8]);
+  void skip(void);
+  void reset_search(void);
+  uint8_t search(uint8_t *newAddr);
+
+private:
+  OneWire *_oneWire;
+};
+
+#endif
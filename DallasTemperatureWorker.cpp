@@ -0,0 +1,298 @@
+/*!
+ * @file DallasTemperatureWorker.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperatureWorker.h"
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+// the indexes wrap at the queue size
+#define WORKERQUEUEMASK (WORKERQUEUESIZE - 1)
+
+DallasTemperatureWorker::DallasTemperatureWorker(DallasTemperature *sensors) {
+  _sensors = sensors;
+  head = 0;
+  tail = 0;
+  for (uint8_t i = 0; i < 2; i++) {
+    snapshots[i].count = 0;
+    snapshots[i].timestamp = 0;
+    snapshots[i].sequence = 0;
+    version[i] = 0;
+  }
+  front = 0;
+  sweepInterval = 0;
+  sweepStart = 0;
+  sweeping = false;
+#if defined(ARDUINO_ARCH_ESP32)
+  task = 0;
+#endif
+}
+
+// commands wait while a sweep runs, so a conversion is never interrupted by
+// other traffic
+void DallasTemperatureWorker::service(void) {
+  if (sweeping) {
+    if (_sensors->poll() != DallasTemperature::CONVERSION_DONE)
+      return;
+    publish();
+    sweeping = false;
+  }
+
+  bool request = false;
+  DeviceAddress address;
+  while (tail != head) {
+    __sync_synchronize();
+    QueueEntry entry = queue[tail];
+    __sync_synchronize();
+    tail = (tail + 1) & WORKERQUEUEMASK;
+
+    switch (entry.command) {
+    case COMMAND_BEGIN:
+      _sensors->begin();
+      break;
+    case COMMAND_RESOLUTION:
+      _sensors->setResolution(entry.value);
+      break;
+    case COMMAND_DEVICE_RESOLUTION:
+      if (_sensors->getAddress(address, entry.index))
+        _sensors->setResolution(address, entry.value);
+      break;
+    case COMMAND_PARTIAL_READ:
+      _sensors->setPartialRead(entry.value);
+      break;
+#if REQUIRESALARMS
+    case COMMAND_HIGH_ALARM:
+      if (_sensors->getAddress(address, entry.index))
+        _sensors->setHighAlarmTemp(address, (char)entry.value);
+      break;
+    case COMMAND_LOW_ALARM:
+      if (_sensors->getAddress(address, entry.index))
+        _sensors->setLowAlarmTemp(address, (char)entry.value);
+      break;
+#endif
+    case COMMAND_REQUEST:
+      request = true;
+      break;
+    }
+  }
+
+  uint32_t interval = sweepInterval;
+  if (request || (interval && (millis() - sweepStart) >= interval)) {
+    // the worker owns the bus, so it can search again from its own task
+    if (_sensors->needsBegin())
+      _sensors->begin();
+    sweepStart = millis();
+    _sensors->startConversion();
+    sweeping = true;
+  }
+}
+
+// poll() has left every reading in the device table
+void DallasTemperatureWorker::publish(void) {
+  uint8_t back = front ^ 1;
+  TemperatureSnapshot *snapshot = &snapshots[back];
+
+  version[back]++;
+  __sync_synchronize();
+
+  uint8_t count = _sensors->getDeviceCount();
+  if (count > MAXDEVICES)
+    count = MAXDEVICES;
+  snapshot->count = count;
+  for (uint8_t i = 0; i < count; i++) {
+    snapshot->raw[i] = _sensors->getLastTempRawByIndex(i);
+    // every index is in the device table, so this doesn't touch the bus
+    _sensors->getAddress(snapshot->address[i], i);
+  }
+  snapshot->timestamp = millis();
+  snapshot->sequence = snapshots[front].sequence + 1;
+
+  __sync_synchronize();
+  version[back]++;
+  __sync_synchronize();
+  front = back;
+}
+
+bool DallasTemperatureWorker::submit(uint8_t command, uint8_t value,
+                                     uint8_t index) {
+  uint8_t next = (head + 1) & WORKERQUEUEMASK;
+  if (next == tail)
+    return false;
+
+  queue[head].command = command;
+  queue[head].index = index;
+  queue[head].value = value;
+  __sync_synchronize();
+  head = next;
+  return true;
+}
+
+bool DallasTemperatureWorker::begin(void) { return submit(COMMAND_BEGIN, 0); }
+
+bool DallasTemperatureWorker::requestTemperatures(void) {
+  return submit(COMMAND_REQUEST, 0);
+}
+
+bool DallasTemperatureWorker::setResolution(uint8_t newResolution) {
+  return submit(COMMAND_RESOLUTION, newResolution);
+}
+
+bool DallasTemperatureWorker::setResolution(uint8_t deviceIndex,
+                                            uint8_t newResolution) {
+  return submit(COMMAND_DEVICE_RESOLUTION, newResolution, deviceIndex);
+}
+
+bool DallasTemperatureWorker::setPartialRead(bool flag) {
+  return submit(COMMAND_PARTIAL_READ, flag);
+}
+
+#if REQUIRESALARMS
+
+bool DallasTemperatureWorker::setHighAlarmTemp(uint8_t deviceIndex,
+                                               char celsius) {
+  return submit(COMMAND_HIGH_ALARM, (uint8_t)celsius, deviceIndex);
+}
+
+bool DallasTemperatureWorker::setLowAlarmTemp(uint8_t deviceIndex,
+                                              char celsius) {
+  return submit(COMMAND_LOW_ALARM, (uint8_t)celsius, deviceIndex);
+}
+
+#endif
+
+void DallasTemperatureWorker::setInterval(uint32_t interval) {
+  sweepInterval = interval;
+}
+
+// copies again if the worker wrote the buffer while it was being copied. The
+// worker never writes the front buffer, so a retry only happens when it
+// flipped the buffers and started the next sweep mid-copy. yield() lets a
+// worker on the same core finish publishing instead of spinning against it
+void DallasTemperatureWorker::getSnapshot(TemperatureSnapshot *snapshot) {
+  for (;;) {
+    uint8_t current = front;
+    uint32_t before = version[current];
+    __sync_synchronize();
+    if (!(before & 1)) {
+      *snapshot = snapshots[current];
+      __sync_synchronize();
+      if (version[current] == before)
+        return;
+    }
+    yield();
+  }
+}
+
+uint32_t DallasTemperatureWorker::getSequence(void) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  return snapshot.sequence;
+}
+
+uint8_t DallasTemperatureWorker::getDeviceCount(void) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  return snapshot.count;
+}
+
+int16_t DallasTemperatureWorker::getTempRawByIndex(uint8_t deviceIndex) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  if (deviceIndex >= snapshot.count)
+    return DEVICE_DISCONNECTED_RAW;
+  return snapshot.raw[deviceIndex];
+}
+
+float DallasTemperatureWorker::getTempCByIndex(uint8_t deviceIndex) {
+  return DallasTemperature::rawToCelsius(getTempRawByIndex(deviceIndex));
+}
+
+float DallasTemperatureWorker::getTempC(const uint8_t *deviceAddress) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  for (uint8_t i = 0; i < snapshot.count; i++) {
+    if (memcmp(snapshot.address[i], deviceAddress, sizeof(DeviceAddress)) == 0)
+      return DallasTemperature::rawToCelsius(snapshot.raw[i]);
+  }
+  return DEVICE_DISCONNECTED;
+}
+
+bool DallasTemperatureWorker::getAddress(uint8_t *deviceAddress,
+                                         uint8_t deviceIndex) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  if (deviceIndex >= snapshot.count)
+    return false;
+  memcpy(deviceAddress, snapshot.address[deviceIndex], sizeof(DeviceAddress));
+  return true;
+}
+
+uint8_t DallasTemperatureWorker::readAllTempsC(float *temps,
+                                               uint8_t maxTemps) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  uint8_t count = min(snapshot.count, maxTemps);
+  uint8_t valid = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    temps[i] = DallasTemperature::rawToCelsius(snapshot.raw[i]);
+    if (snapshot.raw[i] != DEVICE_DISCONNECTED_RAW &&
+        snapshot.raw[i] != DEVICE_FAULT_RAW)
+      valid++;
+  }
+  return valid;
+}
+
+uint8_t DallasTemperatureWorker::readAllTempsRaw(int16_t *temps,
+                                                 uint8_t maxTemps) {
+  TemperatureSnapshot snapshot;
+  getSnapshot(&snapshot);
+  uint8_t count = min(snapshot.count, maxTemps);
+  uint8_t valid = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    temps[i] = snapshot.raw[i];
+    if (temps[i] != DEVICE_DISCONNECTED_RAW && temps[i] != DEVICE_FAULT_RAW)
+      valid++;
+  }
+  return valid;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool DallasTemperatureWorker::beginTask(uint8_t core, uint32_t stackSize,
+                                        uint8_t priority) {
+  if (task)
+    return true;
+#if CONFIG_FREERTOS_UNICORE
+  core = 0;
+#endif
+  return xTaskCreatePinnedToCore(taskEntry, "DallasTemp", stackSize, this,
+                                 priority, &task, core) == pdPASS;
+}
+
+void DallasTemperatureWorker::endTask(void) {
+  if (task) {
+    vTaskDelete(task);
+    task = 0;
+  }
+}
+
+// one tick between calls keeps the read time slots of poll() from starving
+// other tasks on the core
+void DallasTemperatureWorker::taskEntry(void *worker) {
+  for (;;) {
+    ((DallasTemperatureWorker *)worker)->service();
+    vTaskDelay(1);
+  }
+}
+
+#endif
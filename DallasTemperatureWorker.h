@@ -0,0 +1,259 @@
+/*!
+ * @file DallasTemperatureWorker.h
+ */
+#ifndef DallasTemperatureWorker_h
+#define DallasTemperatureWorker_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#ifndef WORKERQUEUESIZE
+#define WORKERQUEUESIZE                                                        \
+  8 //!< number of commands the worker buffers, a power of two up to 128
+#endif
+
+// the ring indices are uint8_t and wrap with a mask of the size
+#if WORKERQUEUESIZE <= 0 || WORKERQUEUESIZE > 128 || (WORKERQUEUESIZE & (WORKERQUEUESIZE - 1)) != 0
+#error "WORKERQUEUESIZE must be a power of two up to 128"
+#endif
+
+/*!
+ * @brief results of one sweep over the device table
+ */
+typedef struct {
+  uint8_t count;                     //!< number of devices in raw
+  int16_t raw[MAXDEVICES];           //!< raw temperatures, device table order
+  DeviceAddress address[MAXDEVICES]; //!< ROM codes, device table order
+  unsigned long timestamp;           //!< millis() when the sweep finished
+  uint32_t sequence;                 //!< sweep number, 0 before the first
+} TemperatureSnapshot;
+
+/*!
+ * @brief Moves all bus traffic of a DallasTemperature to one core. The worker
+ * side, service(), runs on the bus core and is the only code that touches
+ * the bus. The application core submits commands through a queue and reads
+ * the results from a double buffered snapshot, neither side ever waits for
+ * the other. Commands must come from one core only. On ESP32 beginTask() runs
+ * service() in a task pinned to a core, on RP2040 call service() from
+ * loop1().
+ *
+ * The worker mirrors a subset of the DallasTemperature API: begin(),
+ * requestTemperatures(), setResolution(), setPartialRead() and the alarm
+ * thresholds are queued, getAddress(), getTempC(), getTempCByIndex() and the
+ * readAllTemps calls answer from the snapshot. Everything else, such as
+ * alarm searches and handlers, change reporting, poll(), the scheduler and
+ * scratchpad access, isn't mirrored: call it before the worker starts, or
+ * only from the core that runs service()
+ */
+class DallasTemperatureWorker {
+public:
+  /*!
+   * @brief DallasTemperatureWorker constructor
+   * @param sensors Bus the worker owns
+   */
+  DallasTemperatureWorker(DallasTemperature *sensors);
+
+  /*!
+   * @brief runs queued commands and advances the current sweep, call it
+   * often from the bus core. Never blocks for a conversion
+   */
+  void service(void);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /*!
+   * @brief runs service() in a FreeRTOS task pinned to a core. The Arduino
+   * loop() runs on core 1, so the default core 0 keeps the bit timing off the
+   * application core. Core 0 is shared with the Wi-Fi stack, not dedicated to
+   * the bus: OneWire's time slots are short critical sections and the task
+   * yields for a tick between calls to service()
+   * @param core Core to pin the task to
+   * @param stackSize Task stack size in bytes
+   * @param priority Task priority
+   * @return Returns false if the task couldn't be created
+   */
+  bool beginTask(uint8_t core = 0, uint32_t stackSize = 2048,
+                 uint8_t priority = 1);
+
+  /*!
+   * @brief deletes the task started by beginTask()
+   */
+  void endTask(void);
+#endif
+
+  /*!
+   * @brief queues a begin() to enumerate the bus again
+   * @return Returns false if the queue is full
+   */
+  bool begin(void);
+
+  /*!
+   * @brief queues a sweep: a conversion followed by a read of every cached
+   * device into the snapshot
+   * @return Returns false if the queue is full
+   */
+  bool requestTemperatures(void);
+
+  /*!
+   * @brief queues a setResolution() for all devices
+   * @param newResolution 9-12
+   * @return Returns false if the queue is full
+   */
+  bool setResolution(uint8_t newResolution);
+
+  /*!
+   * @brief queues a setResolution() for one device
+   * @param deviceIndex Index of the device
+   * @param newResolution 9-12
+   * @return Returns false if the queue is full
+   */
+  bool setResolution(uint8_t deviceIndex, uint8_t newResolution);
+
+  /*!
+   * @brief queues a setPartialRead()
+   * @param flag What value to set the partialRead flag to
+   * @return Returns false if the queue is full
+   */
+  bool setPartialRead(bool flag);
+
+#if REQUIRESALARMS
+  /*!
+   * @brief queues a setHighAlarmTemp() for one device
+   * @param deviceIndex Index of the device
+   * @param celsius Alarm temperature in degrees C
+   * @return Returns false if the queue is full
+   */
+  bool setHighAlarmTemp(uint8_t deviceIndex, char celsius);
+
+  /*!
+   * @brief queues a setLowAlarmTemp() for one device
+   * @param deviceIndex Index of the device
+   * @param celsius Alarm temperature in degrees C
+   * @return Returns false if the queue is full
+   */
+  bool setLowAlarmTemp(uint8_t deviceIndex, char celsius);
+#endif
+
+  /*!
+   * @brief sweeps the bus on its own every interval
+   * @param interval Time between the starts of two sweeps in ms, 0 to sweep
+   * on requestTemperatures() only
+   */
+  void setInterval(uint32_t interval);
+
+  /*!
+   * @brief copies the latest snapshot
+   * @param snapshot Filled with the snapshot
+   */
+  void getSnapshot(TemperatureSnapshot *snapshot);
+
+  /*!
+   * @brief returns the number of finished sweeps, it changes when a new
+   * snapshot is available
+   * @return Sweep count
+   */
+  uint32_t getSequence(void);
+
+  /*!
+   * @brief returns the number of devices in the latest snapshot
+   * @return Device count
+   */
+  uint8_t getDeviceCount(void);
+
+  /*!
+   * @brief returns a raw temperature from the latest snapshot
+   * @param deviceIndex Index of the device
+   * @return Raw temperature, DEVICE_DISCONNECTED_RAW if it wasn't read
+   */
+  int16_t getTempRawByIndex(uint8_t deviceIndex);
+
+  /*!
+   * @brief returns a temperature from the latest snapshot
+   * @param deviceIndex Index of the device
+   * @return Degrees C, DEVICE_DISCONNECTED if it wasn't read
+   */
+  float getTempCByIndex(uint8_t deviceIndex);
+
+  /*!
+   * @brief returns a temperature from the latest snapshot
+   * @param deviceAddress Address of the device
+   * @return Degrees C, DEVICE_DISCONNECTED if it wasn't read
+   */
+  float getTempC(const uint8_t *deviceAddress);
+
+  /*!
+   * @brief copies the address of a device from the latest snapshot
+   * @param deviceAddress Filled with the address
+   * @param deviceIndex Index of the device
+   * @return Returns false if the snapshot has no such device
+   */
+  bool getAddress(uint8_t *deviceAddress, uint8_t deviceIndex);
+
+  /*!
+   * @brief copies the temperatures of the latest snapshot, like
+   * DallasTemperature::readAllTempsC() without touching the bus
+   * @param temps Array to fill in device table order
+   * @param maxTemps Size of the temps array
+   * @return Returns the number of valid temperatures
+   */
+  uint8_t readAllTempsC(float *temps, uint8_t maxTemps);
+
+  /*!
+   * @brief copies the raw temperatures of the latest snapshot
+   * @param temps Array to fill in device table order
+   * @param maxTemps Size of the temps array
+   * @return Returns the number of valid temperatures
+   */
+  uint8_t readAllTempsRaw(int16_t *temps, uint8_t maxTemps);
+
+private:
+  DallasTemperature *_sensors;
+
+  typedef enum {
+    COMMAND_BEGIN,
+    COMMAND_REQUEST,
+    COMMAND_RESOLUTION,
+    COMMAND_DEVICE_RESOLUTION,
+    COMMAND_PARTIAL_READ,
+    COMMAND_HIGH_ALARM,
+    COMMAND_LOW_ALARM
+  } Command;
+
+  // command ring, head is only written by clients, tail by the worker
+  typedef struct {
+    uint8_t command;
+    uint8_t index; // device index of per-device commands
+    uint8_t value;
+  } QueueEntry;
+  QueueEntry queue[WORKERQUEUESIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+
+  // the worker writes snapshots[!front] and then swaps front. The version of
+  // a buffer is odd while it is being written, so a reader that was
+  // overtaken by two swaps notices and copies again
+  TemperatureSnapshot snapshots[2];
+  volatile uint32_t version[2];
+  volatile uint8_t front;
+
+  volatile uint32_t sweepInterval;
+  unsigned long sweepStart;
+  bool sweeping;
+
+  // queues a command, false if the queue is full
+  bool submit(uint8_t command, uint8_t value, uint8_t index = 0);
+
+  // copies the device table readings into the back buffer and swaps it in
+  void publish(void);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  TaskHandle_t task;
+
+  static void taskEntry(void *);
+#endif
+};
+
+#endif
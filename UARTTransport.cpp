@@ -0,0 +1,96 @@
+/*!
+ * @file UARTTransport.cpp
+ */
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "UARTTransport.h"
+
+#if REQUIRESUART
+
+// a reset is a 0xF0 character at 9600 baud, time slots use 115200 baud where
+// 0xFF is a write 1/read slot and 0x00 a write 0 slot
+#define UART_RESET_BAUD 9600
+#define UART_SLOT_BAUD 115200
+#define UART_RESET_CHAR 0xF0
+#define UART_SLOT_1 0xFF
+#define UART_SLOT_0 0x00
+
+// a character at 9600 baud takes about 1ms
+#define UART_TIMEOUT_MS 5
+
+UARTTransport::UARTTransport(HardwareSerial *serial) {
+  _serial = serial;
+  _baud = 0;
+}
+
+// any device pulling the line low during the reset character changes the echo
+uint8_t UARTTransport::reset(void) {
+  setBaud(UART_RESET_BAUD);
+  while (_serial->available())
+    _serial->read();
+
+  _serial->write((uint8_t)UART_RESET_CHAR);
+  int echo = readEcho();
+
+  setBaud(UART_SLOT_BAUD);
+  return (echo >= 0 && echo != UART_RESET_CHAR) ? 1 : 0;
+}
+
+// begin() runs once. ESP32 and ESP8266 change the divisor in place, other
+// cores have no such call and begin() again, which only reloads the baud
+// registers on AVR but reinitialises the peripheral on SAMD and others
+void UARTTransport::setBaud(unsigned long baud) {
+  if (baud == _baud)
+    return;
+  _serial->flush();
+  if (_baud == 0)
+    _serial->begin(baud);
+  else {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    _serial->updateBaudRate(baud);
+#else
+    _serial->begin(baud);
+#endif
+  }
+  _baud = baud;
+}
+
+void UARTTransport::write_bit(uint8_t v) { exchange(v ? 1 : 0, 1); }
+
+uint8_t UARTTransport::read_bit(void) { return exchange(1, 1); }
+
+void UARTTransport::write(uint8_t v, uint8_t power) { exchange(v, 8); }
+
+uint8_t UARTTransport::read(void) { return exchange(0xFF, 8); }
+
+// queues all time slots before collecting the echoes so the UART keeps the
+// line busy, a bit reads as 1 unless a device pulled its slot low
+uint8_t UARTTransport::exchange(uint8_t v, uint8_t bits) {
+  while (_serial->available())
+    _serial->read();
+
+  for (uint8_t i = 0; i < bits; i++)
+    _serial->write((uint8_t)((v & (1 << i)) ? UART_SLOT_1 : UART_SLOT_0));
+
+  uint8_t result = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    if (readEcho() == UART_SLOT_1)
+      result |= (1 << i);
+  }
+  return result;
+}
+
+// returns the next character echoed by the bus, -1 on timeout
+int UARTTransport::readEcho(void) {
+  unsigned long start = millis();
+  while (!_serial->available()) {
+    if ((millis() - start) >= UART_TIMEOUT_MS)
+      return -1;
+  }
+  return _serial->read();
+}
+
+#endif
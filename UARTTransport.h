@@ -0,0 +1,64 @@
+/*!
+ * @file UARTTransport.h
+ */
+#ifndef UARTTransport_h
+#define UARTTransport_h
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+#include "DallasTemperature.h"
+
+#if REQUIRESUART
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+extern "C" {
+#include "WConstants.h"
+}
+#endif
+
+/*!
+ * @brief transport over a hardware UART with TX and RX tied to the 1-Wire
+ * line (TX through a diode or open drain buffer, see Maxim tutorial 214).
+ * Every time slot is one UART character, so the UART hardware does the
+ * timing and interrupts stay enabled. There is no strong pullup, so parasite
+ * powered devices aren't supported
+ */
+class UARTTransport : public DallasTemperatureTransport {
+public:
+  /*!
+   * @brief UARTTransport constructor
+   * @param serial UART wired to the bus
+   */
+  UARTTransport(HardwareSerial *serial);
+
+  uint8_t reset(void);
+  void write_bit(uint8_t v);
+  uint8_t read_bit(void);
+  void write(uint8_t v, uint8_t power = 0);
+  uint8_t read(void);
+
+private:
+  HardwareSerial *_serial;
+
+  // baud rate the UART runs at, 0 before the first reset
+  unsigned long _baud;
+
+  // switches the UART to a baud rate, starting it on the first call
+  void setBaud(unsigned long baud);
+
+  // sends one time slot per bit of v, LSB first, and returns the bits read
+  // back from the bus
+  uint8_t exchange(uint8_t v, uint8_t bits);
+
+  // returns the next character echoed by the bus, -1 on timeout
+  int readEcho(void);
+};
+
+#endif
+
+#endif
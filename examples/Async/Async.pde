@@ -0,0 +1,43 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// Data wire is plugged into port 2 on the Arduino
+#define ONE_WIRE_BUS 2
+
+// Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
+OneWire oneWire(ONE_WIRE_BUS);
+
+// Pass our oneWire reference to Dallas Temperature. 
+DallasTemperature sensors(&oneWire);
+
+void setup(void)
+{
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature IC Control Library Demo");
+
+  // Start up the library
+  sensors.begin();
+
+  // start the first conversion, poll() takes it from here
+  sensors.startConversion();
+}
+
+void loop(void)
+{ 
+  // poll() never blocks for the conversion, so loop() is free to do other
+  // work (update a display, run a control loop...) in the meantime
+  if (sensors.poll() == DallasTemperature::CONVERSION_DONE)
+  {
+    for (uint8_t i = 0; i < sensors.getDeviceCount(); i++)
+    {
+      Serial.print("Temperature for device ");
+      Serial.print(i, DEC);
+      Serial.print(" is: ");
+      Serial.println(sensors.getLastTempCByIndex(i));
+    }
+
+    // start the next conversion
+    sensors.startConversion();
+  }
+}
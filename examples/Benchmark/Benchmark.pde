@@ -0,0 +1,119 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// Times the main operations of the library on the devices of one bus and
+// prints microseconds per operation. Run it before and after a change to
+// compare. Set REQUIRESSTATS to true in DallasTemperature.h to also print
+// the bus traffic of each operation.
+
+// Data wire is plugged into port 2 on the Arduino
+#define ONE_WIRE_BUS 2
+
+#define RUNS 10
+
+OneWire oneWire(ONE_WIRE_BUS);
+DallasTemperature sensors(&oneWire);
+
+float temps[MAXDEVICES];
+
+void report(const char *name, unsigned long elapsed, unsigned int count)
+{
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(elapsed / count);
+  Serial.print(" us");
+#if REQUIRESSTATS
+  DallasTemperatureStats stats = sensors.getStats();
+  Serial.print(", ");
+  Serial.print(stats.resets / count);
+  Serial.print(" resets, ");
+  Serial.print(stats.scratchPadReads / count);
+  Serial.print(" scratchpad reads, ");
+  Serial.print(stats.searches / count);
+  Serial.print(" searches");
+  sensors.resetStats();
+#endif
+  Serial.println();
+}
+
+void setup(void)
+{
+  unsigned long start;
+
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature Benchmark");
+
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.begin();
+  report("begin()", micros() - start, RUNS);
+
+  uint8_t count = sensors.getDeviceCount();
+  Serial.print(count, DEC);
+  Serial.println(" devices");
+  if (count == 0)
+    return;
+
+  // time the bus traffic only, not the conversion
+  sensors.requestTemperatures();
+  sensors.setWaitForConversion(false);
+#if REQUIRESSTATS
+  sensors.resetStats();
+#endif
+
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    for (uint8_t j = 0; j < count; j++)
+      temps[j] = sensors.getTempCByIndex(j);
+  report("getTempCByIndex() sweep", micros() - start, RUNS);
+
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.readAllTempsC(temps, MAXDEVICES);
+  report("readAllTempsC()", micros() - start, RUNS);
+
+  sensors.setPartialRead(true);
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.readAllTempsC(temps, MAXDEVICES);
+  report("readAllTempsC() partial", micros() - start, RUNS);
+  sensors.setPartialRead(false);
+
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.requestTemperatures();
+  report("requestTemperatures() async", micros() - start, RUNS);
+  sensors.setWaitForConversion(true);
+
+#if REQUIRESALARMS
+  DeviceAddress alarms[MAXDEVICES];
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.alarmSearchAll(alarms, MAXDEVICES);
+  report("alarmSearchAll()", micros() - start, RUNS);
+#endif
+
+  // writes without EEPROM copies, the resolution isn't kept over a reset
+  uint8_t resolution = sensors.getResolution();
+  sensors.setAutoSaveScratchPad(false);
+
+  DeviceAddress deviceAddress;
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    for (uint8_t j = 0; j < count; j++)
+      if (sensors.getAddress(deviceAddress, j))
+        sensors.setResolution(deviceAddress, resolution);
+  report("setResolution(address) sweep", micros() - start, RUNS);
+
+  start = micros();
+  for (int i = 0; i < RUNS; i++)
+    sensors.setResolution(resolution);
+  report("setResolution()", micros() - start, RUNS);
+
+  sensors.setAutoSaveScratchPad(true);
+}
+
+void loop(void)
+{
+}
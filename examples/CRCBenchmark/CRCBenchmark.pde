@@ -0,0 +1,52 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// Times the CRC8 used by the library against OneWire::crc8. Change
+// REQUIRESCRCTABLE in DallasTemperature.h (0 bitwise, 1 256 byte table,
+// 2 nibble tables) and upload again to compare the variants.
+
+#define RUNS 10000
+
+// a valid DS18B20 scratchpad, 85 degrees C power on value
+uint8_t scratchPad[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x1C };
+
+volatile uint8_t sink;
+
+void setup(void)
+{
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature CRC8 Benchmark");
+
+  Serial.print("REQUIRESCRCTABLE: ");
+  Serial.println(REQUIRESCRCTABLE, DEC);
+
+  // both implementations must agree before timing them
+  if (DallasTemperature::crc8(scratchPad, 9) != 0 ||
+      OneWire::crc8(scratchPad, 8) != scratchPad[8])
+  {
+    Serial.println("CRC mismatch");
+    return;
+  }
+
+  unsigned long start = micros();
+  for (unsigned int i = 0; i < RUNS; i++)
+    sink = OneWire::crc8(scratchPad, 8);
+  unsigned long oneWireTime = micros() - start;
+
+  start = micros();
+  for (unsigned int i = 0; i < RUNS; i++)
+    sink = DallasTemperature::crc8(scratchPad, 8);
+  unsigned long libraryTime = micros() - start;
+
+  Serial.print("OneWire::crc8: ");
+  Serial.print((float)oneWireTime / RUNS);
+  Serial.println(" us per scratchpad");
+  Serial.print("DallasTemperature::crc8: ");
+  Serial.print((float)libraryTime / RUNS);
+  Serial.println(" us per scratchpad");
+}
+
+void loop(void)
+{
+}
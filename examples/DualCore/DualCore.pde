@@ -0,0 +1,66 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <DallasTemperatureWorker.h>
+
+// Data wire is plugged into port 2 on the Arduino
+#define ONE_WIRE_BUS 2
+
+// Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
+OneWire oneWire(ONE_WIRE_BUS);
+
+// Pass our oneWire reference to Dallas Temperature. 
+DallasTemperature sensors(&oneWire);
+
+// The worker owns the bus, everything else goes through it
+DallasTemperatureWorker worker(&sensors);
+
+uint32_t lastSequence = 0;
+
+void setup(void)
+{
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature IC Control Library Demo");
+
+  // queued for the bus core
+  worker.begin();
+  worker.setInterval(1000);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  // loop() runs on core 1, so the bus task goes to core 0 where it shares
+  // the CPU with the Wi-Fi stack
+  worker.beginTask(0);
+#endif
+}
+
+#if defined(ARDUINO_ARCH_RP2040)
+// the second core runs the bus
+void loop1(void)
+{
+  worker.service();
+}
+#endif
+
+void loop(void)
+{ 
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_RP2040)
+  // single core boards drive the worker from loop()
+  worker.service();
+#endif
+
+  // the snapshot is never locked, this returns at once
+  if (worker.getSequence() != lastSequence)
+  {
+    TemperatureSnapshot snapshot;
+    worker.getSnapshot(&snapshot);
+    lastSequence = snapshot.sequence;
+
+    for (uint8_t i = 0; i < snapshot.count; i++)
+    {
+      Serial.print("Temperature for device ");
+      Serial.print(i, DEC);
+      Serial.print(" is: ");
+      Serial.println(DallasTemperature::rawToCelsius(snapshot.raw[i]));
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <DallasTemperatureGroup.h>
+
+// Every bus has its own data wire
+OneWire oneWireA(2);
+OneWire oneWireB(3);
+OneWire oneWireC(4);
+
+DallasTemperature sensorsA(&oneWireA);
+DallasTemperature sensorsB(&oneWireB);
+DallasTemperature sensorsC(&oneWireC);
+
+// The group converts all buses at the same time
+DallasTemperatureGroup sensors;
+
+float temps[3 * MAXDEVICES];
+
+void setup(void)
+{
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature IC Control Library Demo");
+
+  sensors.addBus(&sensorsA);
+  sensors.addBus(&sensorsB);
+  sensors.addBus(&sensorsC);
+
+  // Start up the library on every bus
+  sensors.begin();
+}
+
+void loop(void)
+{ 
+  // one conversion time for all buses together
+  Serial.print("Requesting temperatures...");
+  sensors.requestTemperatures();
+  Serial.println("DONE");
+
+  uint8_t count = sensors.getDeviceCount();
+  sensors.readAllTempsC(temps, count);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint8_t bus, device;
+    sensors.locateDevice(i, &bus, &device);
+    Serial.print("Bus ");
+    Serial.print(bus, DEC);
+    Serial.print(" device ");
+    Serial.print(device, DEC);
+    Serial.print(": ");
+    Serial.println(temps[i]);
+  }
+}
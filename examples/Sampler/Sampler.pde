@@ -0,0 +1,53 @@
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <DallasTemperatureSampler.h>
+
+// Data wire is plugged into port 2 on the Arduino
+#define ONE_WIRE_BUS 2
+
+// Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
+OneWire oneWire(ONE_WIRE_BUS);
+
+// Pass our oneWire reference to Dallas Temperature. 
+DallasTemperature sensors(&oneWire);
+
+// The sampler reads the bus in the background
+DallasTemperatureSampler sampler(&sensors);
+
+void setup(void)
+{
+  // start serial port
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature IC Control Library Demo");
+
+  // Start up the library
+  sensors.begin();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  sampler.beginTask();
+#elif defined(__AVR__) && REQUIRESSAMPLERTIMER
+  sampler.beginTimer();
+#endif
+}
+
+void loop(void)
+{ 
+#if defined(__AVR__) && REQUIRESSAMPLERTIMER
+  // the timer paces the sampler, the bus traffic runs here
+  sampler.service();
+#elif !defined(ARDUINO_ARCH_ESP32)
+  // no timer or task on this board, drive the sampler from loop()
+  sampler.step();
+#endif
+
+  // records can be taken at any time, the sampler keeps filling the buffer
+  SampleRecord record;
+  while (sampler.read(&record))
+  {
+    Serial.print(record.timestamp);
+    Serial.print(" ms: device ");
+    Serial.print(record.index, DEC);
+    Serial.print(" is ");
+    Serial.println(DallasTemperature::rawToCelsius(record.raw));
+  }
+}
@@ -0,0 +1,303 @@
+/*!
+ * @file MockTransport.cpp
+ */
+#include "MockTransport.h"
+#include <Arduino.h>
+#include <DallasTemperature.h>
+
+// time slot lengths on a standard speed bus
+#define RESET_MICROS 960
+#define SLOT_MICROS 65
+
+// datasheet conversion times of 9-12 bits
+static const uint16_t conversionMillis[4] = {94, 188, 375, 750};
+
+// ROM commands not defined by DallasTemperature.h
+#define SEARCHROM 0xF0
+#define SKIPROM 0xCC
+
+MockTransport::MockTransport(void) {
+  count = 0;
+  latency = 0;
+  conversions = 0;
+  copies = 0;
+  mode = MODE_IDLE;
+}
+
+// adds a device with the power-on scratchpad of a DS18B20, 85 degrees C
+uint8_t MockTransport::addDevice(uint8_t family, uint8_t serial, float tempC) {
+  if (count >= MOCKMAXDEVICES)
+    return 0xFF;
+  Device *device = &devices[count];
+  memset(device, 0, sizeof(Device));
+  device->rom[0] = family;
+  device->rom[1] = serial;
+  device->rom[7] = OneWire::crc8(device->rom, 7);
+  device->eeprom[0] = 0x4B;
+  device->eeprom[1] = 0x46;
+  device->eeprom[2] = TEMP_12_BIT;
+  device->scratchPad[TEMP_LSB] = 0x50;
+  device->scratchPad[TEMP_MSB] = 0x05;
+  memcpy(device->scratchPad + HIGH_ALARM_TEMP, device->eeprom, 3);
+  device->scratchPad[INTERNAL_BYTE] = 0xFF;
+  device->scratchPad[COUNT_REMAIN] = 0x0C;
+  device->scratchPad[COUNT_PER_C] = 0x10;
+  device->scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(device->scratchPad, 8);
+  device->tempC = tempC;
+  device->present = true;
+  return count++;
+}
+
+void MockTransport::setTemperature(uint8_t device, float tempC) {
+  devices[device].tempC = tempC;
+}
+
+void MockTransport::corruptReads(uint8_t device, uint8_t reads) {
+  devices[device].badReads = reads;
+}
+
+void MockTransport::setPresent(uint8_t device, bool present) {
+  devices[device].present = present;
+}
+
+void MockTransport::setParasite(uint8_t device, bool parasite) {
+  devices[device].parasite = parasite;
+}
+
+// sets the resolution in EEPROM and the scratchpad, as if it was saved
+void MockTransport::setResolution(uint8_t device, uint8_t resolution) {
+  Device *d = &devices[device];
+  d->eeprom[2] = ((resolution - 9) << 5) | 0x1F;
+  d->scratchPad[CONFIGURATION] = d->eeprom[2];
+  d->scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(d->scratchPad, 8);
+}
+
+void MockTransport::setConversionLatency(uint16_t ms) { latency = ms; }
+
+const uint8_t *MockTransport::getAddress(uint8_t device) {
+  return devices[device].rom;
+}
+
+// every present device answers and waits for a ROM command
+uint8_t MockTransport::reset(void) {
+  advanceMicros(RESET_MICROS);
+  update();
+
+  uint8_t presence = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    devices[i].active = devices[i].present;
+    if (devices[i].present)
+      presence = 1;
+  }
+  mode = MODE_ROMCOMMAND;
+  shift = 0;
+  bitCount = 0;
+  byteCount = 0;
+  return presence;
+}
+
+void MockTransport::write_bit(uint8_t v) {
+  advanceMicros(SLOT_MICROS);
+  update();
+
+  // the master writes the direction after each bit and complement
+  if (mode == MODE_SEARCH) {
+    if (searchPhase != 2)
+      return;
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t bit = (devices[i].rom[bitCount / 8] >> (bitCount % 8)) & 1;
+      if (bit != v)
+        devices[i].active = false;
+    }
+    searchPhase = 0;
+    if (++bitCount == 64)
+      mode = MODE_FUNCTION;
+    return;
+  }
+
+  shift = (shift >> 1) | (v ? 0x80 : 0);
+  if ((++bitCount % 8) == 0)
+    receive(shift);
+}
+
+uint8_t MockTransport::read_bit(void) {
+  advanceMicros(SLOT_MICROS);
+  update();
+
+  uint8_t v = 1;
+  switch (mode) {
+  case MODE_SEARCH:
+    if (searchPhase == 2)
+      return 1;
+    return romBit(bitCount, searchPhase++ == 1);
+
+  case MODE_READSCRATCH:
+    if (bitCount >= 72)
+      return 1;
+    // wired-AND of every addressed device
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t byte = devices[i].scratchPad[bitCount / 8];
+      // a corrupted read flips the CRC byte
+      if (devices[i].corrupt && bitCount / 8 == SCRATCHPAD_CRC)
+        byte = ~byte;
+      if (devices[i].active && !((byte >> (bitCount % 8)) & 1))
+        v = 0;
+    }
+    bitCount++;
+    return v;
+
+  case MODE_CONVERTING:
+    // externally powered devices hold the bus low while converting
+    for (uint8_t i = 0; i < count; i++) {
+      if (devices[i].active && devices[i].converting && !devices[i].parasite)
+        v = 0;
+    }
+    return v;
+
+  case MODE_POWERSUPPLY:
+    for (uint8_t i = 0; i < count; i++) {
+      if (devices[i].active && devices[i].parasite)
+        v = 0;
+    }
+    return v;
+
+  default:
+    return 1;
+  }
+}
+
+// handles a ROM or function command byte, or a data byte
+void MockTransport::receive(uint8_t v) {
+  switch (mode) {
+  case MODE_ROMCOMMAND:
+    bitCount = 0;
+    if (v == SKIPROM) {
+      mode = MODE_FUNCTION;
+    } else if (v == MATCHROM) {
+      mode = MODE_MATCHROM;
+    } else if (v == SEARCHROM || v == ALARMSEARCH) {
+      for (uint8_t i = 0; i < count; i++) {
+        if (v == ALARMSEARCH && !devices[i].alarm)
+          devices[i].active = false;
+      }
+      mode = MODE_SEARCH;
+      searchPhase = 0;
+    } else {
+      mode = MODE_IDLE;
+    }
+    break;
+
+  case MODE_MATCHROM:
+    for (uint8_t i = 0; i < count; i++) {
+      if (devices[i].rom[byteCount] != v)
+        devices[i].active = false;
+    }
+    if (++byteCount == 8) {
+      mode = MODE_FUNCTION;
+      bitCount = 0;
+    }
+    break;
+
+  case MODE_FUNCTION:
+    bitCount = 0;
+    byteCount = 0;
+    mode = MODE_IDLE;
+    if (v == READSCRATCH) {
+      mode = MODE_READSCRATCH;
+      for (uint8_t i = 0; i < count; i++) {
+        Device *d = &devices[i];
+        d->corrupt = d->active && d->badReads;
+        if (d->corrupt)
+          d->badReads--;
+      }
+    } else if (v == WRITESCRATCH) {
+      mode = MODE_WRITESCRATCH;
+    } else if (v == READPOWERSUPPLY) {
+      mode = MODE_POWERSUPPLY;
+    } else if (v == STARTCONVO) {
+      conversions++;
+      for (uint8_t i = 0; i < count; i++) {
+        Device *d = &devices[i];
+        if (!d->active)
+          continue;
+        uint16_t ms = latency ? latency : conversionMillis[resolution(d) - 9];
+        d->converting = true;
+        d->convertingUntil = micros() + ms * 1000UL;
+      }
+      mode = MODE_CONVERTING;
+    } else if (v == COPYSCRATCH) {
+      copies++;
+      for (uint8_t i = 0; i < count; i++) {
+        if (devices[i].active)
+          memcpy(devices[i].eeprom, devices[i].scratchPad + HIGH_ALARM_TEMP,
+                 3);
+      }
+    } else if (v == RECALLSCRATCH) {
+      for (uint8_t i = 0; i < count; i++) {
+        Device *d = &devices[i];
+        if (!d->active)
+          continue;
+        memcpy(d->scratchPad + HIGH_ALARM_TEMP, d->eeprom, 3);
+        d->scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(d->scratchPad, 8);
+      }
+    }
+    break;
+
+  case MODE_WRITESCRATCH:
+    // TH, TL and the configuration register
+    if (byteCount < 3) {
+      for (uint8_t i = 0; i < count; i++) {
+        Device *d = &devices[i];
+        if (!d->active)
+          continue;
+        d->scratchPad[HIGH_ALARM_TEMP + byteCount] = v;
+        d->scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(d->scratchPad, 8);
+      }
+      byteCount++;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+// latches the temperature of every device whose conversion time has passed
+void MockTransport::update(void) {
+  for (uint8_t i = 0; i < count; i++) {
+    Device *d = &devices[i];
+    if (!d->converting || (long)(micros() - d->convertingUntil) < 0)
+      continue;
+    d->converting = false;
+
+    // the undefined low bits of a coarse resolution read as 0
+    int16_t raw = (int16_t)lroundf(d->tempC * 16);
+    raw &= ~((1 << (12 - resolution(d))) - 1);
+    d->scratchPad[TEMP_LSB] = raw & 0xFF;
+    d->scratchPad[TEMP_MSB] = raw >> 8;
+    d->scratchPad[SCRATCHPAD_CRC] = OneWire::crc8(d->scratchPad, 8);
+
+    // the alarm flag compares whole degrees with TH and TL
+    int8_t whole = raw >> 4;
+    d->alarm = whole >= (int8_t)d->scratchPad[HIGH_ALARM_TEMP] ||
+               whole <= (int8_t)d->scratchPad[LOW_ALARM_TEMP];
+  }
+}
+
+// returns the wired-AND of the ROM bit, or its complement, of the active
+// devices
+uint8_t MockTransport::romBit(uint8_t bit, bool complement) {
+  uint8_t v = 1;
+  for (uint8_t i = 0; i < count; i++) {
+    if (!devices[i].active)
+      continue;
+    uint8_t b = (devices[i].rom[bit / 8] >> (bit % 8)) & 1;
+    if ((complement ? !b : b) == 0)
+      v = 0;
+  }
+  return v;
+}
+
+uint8_t MockTransport::resolution(const Device *device) {
+  return ((device->scratchPad[CONFIGURATION] >> 5) & 0x03) + 9;
+}
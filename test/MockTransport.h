@@ -0,0 +1,135 @@
+/*!
+ * @file MockTransport.h
+ */
+#ifndef MockTransport_h
+#define MockTransport_h
+
+#include <DallasTemperatureTransport.h>
+
+#define MOCKMAXDEVICES 16 //!< devices a MockTransport can simulate
+
+/*!
+ * @brief simulated 1-Wire bus of DS18B20 style devices for host tests.
+ * Works at the bit level, so the library's byte, block and search defaults
+ * all run on top of it, and advances the virtual clock per time slot
+ */
+class MockTransport : public DallasTemperatureTransport {
+public:
+  MockTransport(void);
+
+  /*!
+   * @brief adds a device to the bus
+   * @param family Family code, DS18B20MODEL or DS1822MODEL
+   * @param serial Serial number, makes the ROM code unique
+   * @param tempC Temperature the device converts
+   * @return Returns the index of the device, 0xFF if the bus is full
+   */
+  uint8_t addDevice(uint8_t family, uint8_t serial, float tempC);
+
+  /*!
+   * @brief sets the temperature a device converts
+   * @param device Index returned by addDevice()
+   * @param tempC Temperature in degrees C
+   */
+  void setTemperature(uint8_t device, float tempC);
+
+  /*!
+   * @brief connects or disconnects a device
+   * @param device Index returned by addDevice()
+   * @param present false to stop the device answering
+   */
+  void setPresent(uint8_t device, bool present);
+
+  /*!
+   * @brief sets whether a device runs on parasite power
+   * @param device Index returned by addDevice()
+   * @param parasite true for parasite power
+   */
+  void setParasite(uint8_t device, bool parasite);
+
+  /*!
+   * @brief sets the power-on resolution of a device
+   * @param device Index returned by addDevice()
+   * @param resolution 9-12 bits
+   */
+  void setResolution(uint8_t device, uint8_t resolution);
+
+  /*!
+   * @brief sets the conversion time of every device
+   * @param ms Conversion time in ms, 0 for the datasheet time of the
+   * resolution
+   */
+  void setConversionLatency(uint16_t ms);
+
+  /*!
+   * @brief sends the next scratchpads of a device with a bad CRC byte
+   * @param device Index returned by addDevice()
+   * @param reads Number of READ SCRATCHPADs to corrupt, 0 to stop
+   */
+  void corruptReads(uint8_t device, uint8_t reads);
+
+  /*!
+   * @brief returns the ROM code of a device
+   * @param device Index returned by addDevice()
+   * @return Returns the 8 byte ROM code
+   */
+  const uint8_t *getAddress(uint8_t device);
+
+  uint8_t reset(void);
+  void write_bit(uint8_t v);
+  uint8_t read_bit(void);
+
+  unsigned long conversions; //!< STARTCONVO commands received
+  unsigned long copies;      //!< COPY SCRATCHPAD commands received
+
+private:
+  enum Mode {
+    MODE_IDLE,
+    MODE_ROMCOMMAND,
+    MODE_MATCHROM,
+    MODE_SEARCH,
+    MODE_FUNCTION,
+    MODE_READSCRATCH,
+    MODE_WRITESCRATCH,
+    MODE_CONVERTING,
+    MODE_POWERSUPPLY
+  };
+
+  typedef struct {
+    uint8_t rom[8];
+    uint8_t scratchPad[9];
+    uint8_t eeprom[3]; // TH, TL, configuration
+    float tempC;
+    bool present;
+    bool parasite;
+    bool active; // still addressed by the current ROM command
+    bool converting;
+    bool alarm;
+    uint8_t badReads; // scratchpad reads left to corrupt
+    bool corrupt;     // the current scratchpad read has a bad CRC
+    unsigned long convertingUntil;
+  } Device;
+
+  Device devices[MOCKMAXDEVICES];
+  uint8_t count;
+  uint16_t latency;
+
+  Mode mode;
+  uint8_t shift;    // bits of the byte being received
+  uint8_t bitCount; // bits received or sent in the current mode
+  uint8_t byteCount;
+  uint8_t searchPhase; // 0 bit, 1 complement, 2 direction
+
+  // handles a complete byte received in the current mode
+  void receive(uint8_t);
+
+  // latches the temperatures of finished conversions
+  void update(void);
+
+  // returns the wired-AND of the ROM bit of every active device
+  uint8_t romBit(uint8_t, bool);
+
+  static uint8_t resolution(const Device *);
+};
+
+#endif
@@ -0,0 +1,16 @@
+// virtual clock of the host tests
+#include "Arduino.h"
+
+static unsigned long clockMicros = 0;
+
+// reading the clock takes a microsecond, so loops that only wait on millis()
+// come to an end
+unsigned long millis(void) { return ++clockMicros / 1000; }
+
+unsigned long micros(void) { return clockMicros; }
+
+void delay(unsigned long ms) { clockMicros += ms * 1000; }
+
+void delayMicroseconds(unsigned int us) { clockMicros += us; }
+
+void advanceMicros(unsigned long us) { clockMicros += us; }
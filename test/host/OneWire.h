@@ -0,0 +1,41 @@
+// OneWire stand-in for the host tests. Buses are driven by MockTransport, so
+// only crc8() does anything here.
+#ifndef OneWire_h
+#define OneWire_h
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+  OneWire(uint8_t pin) {}
+  uint8_t reset(void) { return 0; }
+  void select(const uint8_t rom[8]) {}
+  void skip(void) {}
+  void write(uint8_t v, uint8_t power = 0) {}
+  void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0) {}
+  uint8_t read(void) { return 0xFF; }
+  void read_bytes(uint8_t *buf, uint16_t count) { memset(buf, 0xFF, count); }
+  void write_bit(uint8_t v) {}
+  uint8_t read_bit(void) { return 1; }
+  void depower(void) {}
+  void reset_search(void) {}
+  uint8_t search(uint8_t *newAddr) { return 0; }
+
+  // Dallas CRC8, bit by bit like OneWire's own fallback
+  static uint8_t crc8(const uint8_t *addr, uint8_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+      uint8_t inbyte = *addr++;
+      for (uint8_t i = 8; i; i--) {
+        uint8_t mix = (crc ^ inbyte) & 0x01;
+        crc >>= 1;
+        if (mix)
+          crc ^= 0x8C;
+        inbyte >>= 1;
+      }
+    }
+    return crc;
+  }
+};
+
+#endif
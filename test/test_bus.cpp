@@ -0,0 +1,459 @@
+// Host test of the bus traffic of DallasTemperature, run against
+// MockTransport with REQUIRESSTATS counting resets, scratchpad reads and
+// searches. Prints every failed check and exits non-zero if there was one.
+#include "MockTransport.h"
+#include <DallasTemperature.h>
+#include <DallasTemperatureGroup.h>
+#include <math.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);     \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+#define DEVICES 4
+
+// a bus of DEVICES DS18B20s at 20, 21, 22 and 23 degrees C
+static void addDevices(MockTransport &bus) {
+  for (uint8_t i = 0; i < DEVICES; i++)
+    bus.addDevice(DS18B20MODEL, i + 1, 20 + i);
+}
+
+// begin() finds every device with one search each plus the one that ends the
+// search, and reads each scratchpad once for its resolution
+static void testBegin(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+
+  DallasTemperatureStats stats = sensors.getStats();
+  CHECK(sensors.getDeviceCount() == DEVICES);
+  CHECK(stats.searches == DEVICES + 1);
+  CHECK(stats.scratchPadReads == DEVICES);
+  CHECK(stats.crcFailures == 0);
+}
+
+// sweeping by index uses the device table like the bulk read: one
+// scratchpad read, two resets and no search per device
+static void testSweep(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  sensors.requestTemperatures();
+
+  sensors.resetStats();
+  float byIndex[DEVICES];
+  for (uint8_t i = 0; i < DEVICES; i++)
+    byIndex[i] = sensors.getTempCByIndex(i);
+  DallasTemperatureStats stats = sensors.getStats();
+  CHECK(stats.scratchPadReads == DEVICES);
+  CHECK(stats.resets == 2 * DEVICES);
+  CHECK(stats.searches == 0);
+
+  sensors.resetStats();
+  float bulk[DEVICES];
+  CHECK(sensors.readAllTempsC(bulk, DEVICES) == DEVICES);
+  stats = sensors.getStats();
+  CHECK(stats.scratchPadReads == DEVICES);
+  CHECK(stats.resets == 2 * DEVICES);
+  CHECK(stats.searches == 0);
+  uint32_t fullMicros = stats.busMillis * 1000 + stats.busMicros;
+
+  for (uint8_t i = 0; i < DEVICES; i++)
+    CHECK(bulk[i] == byIndex[i]);
+  for (uint8_t i = 0; i < DEVICES; i++) {
+    DeviceAddress address;
+    memcpy(address, bus.getAddress(i), sizeof(address));
+    CHECK(sensors.getTempC(address) == 20 + i);
+  }
+
+  // partial reads stop after the temperature bytes
+  sensors.setPartialRead(true);
+  sensors.resetStats();
+  CHECK(sensors.readAllTempsC(bulk, DEVICES) == DEVICES);
+  stats = sensors.getStats();
+  CHECK(stats.scratchPadReads == DEVICES);
+  CHECK(stats.busMillis * 1000 + stats.busMicros < fullMicros);
+}
+
+// the scheduler reads 9-bit devices about 8 times as often as 12-bit ones
+// and reports every read it makes
+static void testScheduler(void) {
+  MockTransport bus;
+  addDevices(bus);
+  bus.setResolution(0, 9);
+  bus.setResolution(1, 9);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  sensors.resetStats();
+
+  unsigned int reads[DEVICES] = {0};
+  unsigned long reported = 0;
+  for (int t = 0; t < 3000; t++) {
+    reported += sensors.pollScheduler();
+    for (uint8_t i = 0; i < DEVICES; i++) {
+      if (sensors.hasNewReading(i))
+        reads[i]++;
+    }
+    delay(1);
+  }
+  CHECK(reported == sensors.getStats().scratchPadReads);
+
+  unsigned int fast = 0, slow = 0;
+  for (uint8_t i = 0; i < DEVICES; i++) {
+    DeviceAddress address;
+    sensors.getAddress(address, i);
+    if (sensors.getResolution(address) == 9)
+      fast += reads[i];
+    else
+      slow += reads[i];
+  }
+  CHECK(slow >= 2 * 3);
+  CHECK(fast >= 5 * slow);
+}
+
+// on a parasite powered bus the scheduler falls back to bus-wide
+// conversions read one device per call
+static void testParasiteScheduler(void) {
+  MockTransport bus;
+  addDevices(bus);
+  for (uint8_t i = 0; i < DEVICES; i++)
+    bus.setParasite(i, true);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  CHECK(sensors.isParasitePowerMode());
+  sensors.resetStats();
+
+  unsigned long reported = 0;
+  bool oneAtATime = true;
+  for (int t = 0; t < 5000; t++) {
+    uint8_t read = sensors.pollScheduler();
+    if (read > 1)
+      oneAtATime = false;
+    reported += read;
+    delay(1);
+  }
+  CHECK(oneAtATime);
+  CHECK(reported >= 4 * DEVICES);
+  CHECK(reported == sensors.getStats().scratchPadReads);
+}
+
+// the alarm search only finds devices outside their TH/TL window
+static void testAlarmSearch(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  DeviceAddress address;
+  for (uint8_t i = 0; i < DEVICES; i++) {
+    memcpy(address, bus.getAddress(i), sizeof(address));
+    sensors.setHighAlarmTemp(address, i == 3 ? 22 : 30);
+    sensors.setLowAlarmTemp(address, -10);
+  }
+  sensors.requestTemperatures();
+
+  sensors.resetStats();
+  DeviceAddress alarms[DEVICES];
+  CHECK(sensors.alarmSearchAll(alarms, DEVICES) == 1);
+  CHECK(memcmp(alarms[0], address, sizeof(address)) == 0);
+  DallasTemperatureStats stats = sensors.getStats();
+  CHECK(stats.scratchPadReads == 0);
+  CHECK(stats.searches > 0);
+  // the search passes are timed like ROM searches
+  CHECK(stats.busMillis * 1000 + stats.busMicros > 0);
+}
+
+// a saved device table replaces the search, a device that went missing is
+// only reported, the bus isn't searched again behind the caller's back
+static uint8_t savedTable[128];
+
+static void writeTable(uint16_t offset, uint8_t value) {
+  savedTable[offset] = value;
+}
+
+static uint8_t readTable(uint16_t offset) { return savedTable[offset]; }
+
+static void testBeginFast(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  CHECK(sensors.getDeviceTableSize() <= sizeof(savedTable));
+  sensors.saveDeviceTable(writeTable);
+
+  DallasTemperature restored(&bus);
+  CHECK(restored.beginFast(readTable));
+  CHECK(restored.getDeviceCount() == DEVICES);
+  CHECK(restored.getStats().searches == 0);
+  CHECK(restored.getStats().scratchPadReads == 0);
+  CHECK(!restored.needsBegin());
+
+  bus.setPresent(2, false);
+  restored.requestTemperatures();
+  float temps[DEVICES];
+  CHECK(restored.readAllTempsC(temps, DEVICES) == DEVICES - 1);
+  CHECK(restored.needsBegin());
+
+  restored.resetStats();
+  restored.startConversion();
+  restored.pollScheduler();
+  CHECK(restored.getStats().searches == 0);
+
+  restored.begin();
+  CHECK(!restored.needsBegin());
+  CHECK(restored.getDeviceCount() == DEVICES - 1);
+}
+
+// an out of range resolution is written as 9 bits, the device table has to
+// hold that, or the restored table no longer matches the device
+static void testResolutionOutOfRange(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  DeviceAddress address;
+  CHECK(sensors.getAddress(address, 0));
+  CHECK(sensors.setResolution(address, 13));
+  CHECK(sensors.getResolution(address) == 9);
+  sensors.saveDeviceTable(writeTable);
+
+  DallasTemperature restored(&bus);
+  CHECK(restored.beginFast(readTable));
+  restored.requestTemperatures();
+  float temps[DEVICES];
+  CHECK(restored.readAllTempsC(temps, DEVICES) == DEVICES);
+  CHECK(!restored.needsBegin());
+}
+
+// 6000 blocking 12-bit conversions wait 75 minutes, past the point where a
+// sum of micros() wraps
+static void testLongWait(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  sensors.setCheckForConversion(false);
+
+  sensors.resetStats();
+  for (uint16_t i = 0; i < 6000; i++)
+    sensors.requestTemperatures();
+  DallasTemperatureStats stats = sensors.getStats();
+  CHECK(stats.conversions == 6000);
+  CHECK(stats.conversionWaitMillis == 6000UL * 750);
+}
+
+// the group waits for the conversions itself, afterwards poll() on each bus
+// reads the devices at once instead of waiting again
+static void testGroup(void) {
+  MockTransport busA, busB;
+  addDevices(busA);
+  addDevices(busB);
+  busB.setParasite(0, true);
+  DallasTemperature sensorsA(&busA), sensorsB(&busB);
+  DallasTemperatureGroup group;
+  group.addBus(&sensorsA);
+  group.addBus(&sensorsB);
+  group.begin();
+
+  group.requestTemperatures();
+  unsigned long start = millis();
+  CHECK(sensorsA.poll() == DallasTemperature::CONVERSION_READING);
+  CHECK(sensorsB.poll() == DallasTemperature::CONVERSION_READING);
+  while (sensorsA.poll() != DallasTemperature::CONVERSION_DONE)
+    ;
+  CHECK(millis() - start < 94);
+  float sum = 0;
+  for (uint8_t i = 0; i < DEVICES; i++)
+    sum += sensorsA.getLastTempCByIndex(i);
+  CHECK(sum == 20 + 21 + 22 + 23);
+}
+
+static uint8_t removedDevices;
+
+static void countRemoved(uint8_t *deviceAddress) { removedDevices++; }
+
+// runs discovery steps until a pass ends
+static void discoveryPass(DallasTemperature &sensors) {
+  while (sensors.discoveryStep())
+    ;
+}
+
+// devices that don't fit the device table are counted by discovery, a device
+// removed from a full table makes room for one of them
+static void testDiscoveryOverflow(void) {
+  MockTransport bus;
+  for (uint8_t i = 0; i < MAXDEVICES; i++)
+    bus.addDevice(DS18B20MODEL, i + 1, 20);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  removedDevices = 0;
+  sensors.setDiscoveryHandlers(0, countRemoved);
+
+  bus.addDevice(DS18B20MODEL, 100, 20);
+  bus.addDevice(DS18B20MODEL, 101, 20);
+  discoveryPass(sensors);
+  CHECK(sensors.getDeviceCount() == MAXDEVICES + 2);
+  CHECK(sensors.getUntrackedDeviceCount() == 2);
+
+  // a getAddress() search in the middle of a pass starts the pass over, so
+  // no device is missed
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    sensors.discoveryStep();
+    DeviceAddress address;
+    CHECK(sensors.getAddress(address, MAXDEVICES + 1));
+    discoveryPass(sensors);
+  }
+  CHECK(removedDevices == 0);
+  CHECK(sensors.getDeviceCount() == MAXDEVICES + 2);
+
+  // the pass that removes a device leaves its room to the next one
+  bus.setPresent(0, false);
+  discoveryPass(sensors);
+  discoveryPass(sensors);
+  CHECK(removedDevices == 1);
+  CHECK(sensors.getDeviceCount() == MAXDEVICES - 1);
+  discoveryPass(sensors);
+  CHECK(sensors.getDeviceCount() == MAXDEVICES + 1);
+  CHECK(sensors.getUntrackedDeviceCount() == 1);
+}
+
+// returns the device table index of a device of the mock bus
+static uint8_t tableIndex(DallasTemperature &sensors, MockTransport &bus,
+                          uint8_t device) {
+  DeviceAddress address;
+  for (uint8_t i = 0; i < sensors.getDeviceCount(); i++) {
+    if (sensors.getAddress(address, i) &&
+        memcmp(address, bus.getAddress(device), sizeof(address)) == 0)
+      return i;
+  }
+  return 0xFF;
+}
+
+// bad CRCs are read again with setRetries(), a device failing
+// SKIPAFTERFAILURES sweeps in a row is skipped with a growing backoff and
+// recovers once it answers
+static void testHealth(void) {
+  MockTransport bus;
+  addDevices(bus);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+  uint8_t index = tableIndex(sensors, bus, 0);
+  CHECK(index < DEVICES);
+  float temps[DEVICES];
+  sensors.requestTemperatures();
+
+  sensors.setRetries(2);
+  bus.corruptReads(0, 2);
+  sensors.resetStats();
+  CHECK(sensors.readAllTempsC(temps, DEVICES) == DEVICES);
+  CHECK(sensors.getStats().crcFailures == 2);
+  CHECK(sensors.getStats().scratchPadReads == DEVICES + 2);
+  CHECK(sensors.getFailuresByIndex(index) == 0);
+
+  sensors.setRetries(0);
+  bus.corruptReads(0, 255);
+  for (uint8_t sweep = 1; sweep <= SKIPAFTERFAILURES; sweep++) {
+    CHECK(sensors.readAllTempsC(temps, DEVICES) == DEVICES - 1);
+    CHECK(sensors.getFailuresByIndex(index) == sweep);
+  }
+
+  // backoff of 1 skipped sweep, a failed probe, then 2 skipped sweeps
+  uint8_t expected[] = {DEVICES - 1, DEVICES, DEVICES - 1, DEVICES - 1};
+  for (uint8_t sweep = 0; sweep < sizeof(expected); sweep++) {
+    sensors.resetStats();
+    sensors.readAllTempsC(temps, DEVICES);
+    CHECK(sensors.getStats().scratchPadReads == expected[sweep]);
+  }
+  CHECK(sensors.getFailuresByIndex(index) == SKIPAFTERFAILURES + 1);
+
+  // the next probe reads the device again
+  bus.corruptReads(0, 0);
+  CHECK(sensors.readAllTempsC(temps, DEVICES) == DEVICES);
+  CHECK(sensors.getFailuresByIndex(index) == 0);
+  CHECK(temps[index] == 20);
+  sensors.resetStats();
+  sensors.readAllTempsC(temps, DEVICES);
+  CHECK(sensors.getStats().scratchPadReads == DEVICES);
+}
+
+// converts and reads the one device of a bus at a new temperature
+static void feed(DallasTemperature &sensors, MockTransport &bus, float tempC) {
+  int16_t raw;
+  bus.setTemperature(0, tempC);
+  sensors.requestTemperatures();
+  sensors.readAllTempsRaw(&raw, 1);
+}
+
+// returns the filtered temperature of device 0 with a filter
+static float filtered(DallasTemperature &sensors,
+                      DallasTemperature::FilterType type) {
+  sensors.setFilter(type);
+  return sensors.getFilteredTempCByIndex(0);
+}
+
+#define NEAR(a, b) (fabs((a) - (b)) < 0.001)
+
+// a spike of 40 in samples of 20, checked while the FILTERDEPTH 4 ring fills
+// and after it wrapped
+static void testFilter(void) {
+  MockTransport bus;
+  bus.addDevice(DS18B20MODEL, 1, 20);
+  DallasTemperature sensors(&bus);
+  sensors.begin();
+
+  feed(sensors, bus, 20);
+  feed(sensors, bus, 20);
+  feed(sensors, bus, 40);
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_NONE), 40));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_AVERAGE),
+             20480 / 3 / 256.0));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_EMA), 28));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_MEDIAN3), 20));
+
+  feed(sensors, bus, 20);
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_MEDIAN3), 20));
+
+  // the ring now holds 40, 20, 20, 24
+  feed(sensors, bus, 20);
+  feed(sensors, bus, 24);
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_NONE), 24));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_AVERAGE), 26));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_EMA), 5972 / 256.0));
+  CHECK(NEAR(filtered(sensors, DallasTemperature::FILTER_MEDIAN3), 20));
+
+  // a bulk read pushes the spike out with another 24 and returns the
+  // filtered value of 20, 20, 24, 24
+  sensors.setFilter(DallasTemperature::FILTER_AVERAGE);
+  int16_t raw;
+  CHECK(sensors.readAllTempsRaw(&raw, 1) == 1);
+  CHECK(raw == 22 * 16);
+}
+
+int main(void) {
+  testBegin();
+  testSweep();
+  testScheduler();
+  testParasiteScheduler();
+  testAlarmSearch();
+  testBeginFast();
+  testResolutionOutOfRange();
+  testLongWait();
+  testGroup();
+  testDiscoveryOverflow();
+  testHealth();
+  testFilter();
+
+  if (failures)
+    printf("%d checks failed\n", failures);
+  else
+    printf("all checks passed\n");
+  return failures ? 1 : 0;
+}